@@ -0,0 +1,249 @@
+// Benchmark of the sorting algorithms on random, sorted and reversed int arrays, and of the string sorts on
+// URL-like keys with long shared prefixes
+// The parallel radix sort is compared with a parallel comparison sort: std::sort of one part per worker of the
+// default scheduler, merged pairwise in parallel.
+// The record file sorts run on a temporary file under /tmp, rewritten before every sample.
+// The small-array rows sort SMALL_ELEMENTS random doubles per sample as arrays of 40, 300 and 1000 elements, where
+// the sampling pass of auto_sort is not negligible against the sort itself.
+//
+// Usage: bench [n] [json file]
+//
+// The quadratic sorts only run up to QUADRATIC_LIMIT elements. Every sort works on a fresh copy of the input,
+// the copy is not timed.
+
+#include "sort.hpp"
+#include "record_file.hpp"
+#include "../common/benchmark.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+static constexpr size_t QUADRATIC_LIMIT = 20000;
+// elements per sample of the small-array rows, sorted as many separate arrays
+static constexpr size_t SMALL_ELEMENTS = 1 << 16;
+
+typedef void (*Sort)(std::vector<int> &, std::less<int>);
+typedef void (*StringSort)(std::vector<std::string> &);
+
+// an int that counts assignments, the writes into existing elements (a swap is two)
+struct Tracked {
+    static size_t writes;
+    int value;
+
+    Tracked(int value = 0) : value(value) {}
+
+    Tracked(const Tracked &) = default;
+
+    Tracked &operator=(const Tracked &that) {
+        value = that.value;
+        writes++;
+        return *this;
+    }
+
+    bool operator<(const Tracked &that) const { return value < that.value; }
+};
+
+size_t Tracked::writes = 0;
+
+typedef void (*TrackedSort)(std::vector<Tracked> &, std::less<Tracked>);
+
+// std::sort below grain elements, otherwise both halves in parallel and an in-place merge
+static void parallel_std_sort(std::vector<int> &v, size_t first, size_t last, size_t grain) {
+    if (last - first <= grain) {
+        std::sort(v.begin() + first, v.begin() + last);
+        return;
+    }
+    size_t mid = first + (last - first) / 2;
+    Parallel::invoke([&]() { parallel_std_sort(v, first, mid, grain); },
+                     [&]() { parallel_std_sort(v, mid, last, grain); });
+    std::inplace_merge(v.begin() + first, v.begin() + mid, v.begin() + last);
+}
+
+// n keys from a few hosts and paths, differing only after a long common prefix
+static std::vector<std::string> urls(size_t n, std::mt19937 &rng) {
+    const char *const hosts[] = {"https://www.example.com/", "https://api.example.com/v1/", "https://cdn.example.org/"};
+    const char *const paths[] = {"users/", "users/profile/", "logs/2022/10/", "static/images/thumbnails/"};
+    std::uniform_int_distribution<int> digit(0, 9);
+    std::vector<std::string> keys(n);
+    for (auto &key : keys) {
+        key = std::string(hosts[rng() % 3]) + paths[rng() % 4];
+        for (int i = 0; i < 8; i++) key += static_cast<char>('0' + digit(rng));
+        key += "?page=";
+        key += std::to_string(rng() % 100);
+    }
+    return keys;
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? static_cast<size_t>(std::atol(argv[1])) : 100000;
+    const std::pair<const char *, Sort> sorts[] = {
+            {"bubble_sort", bubble_sort<int, std::less<int>>},
+            {"insertion_sort", insertion_sort<int, std::less<int>>},
+            {"selection_sort", selection_sort<int, std::less<int>>},
+            {"merge_sort", merge_sort<int, std::less<int>>},
+            {"quick_sort_extra", quick_sort_extra<int, std::less<int>>},
+            {"quick_sort_inplace", quick_sort_inplace<int, std::less<int>>},
+            {"write_optimal_sort", write_optimal_sort<int, std::less<int>>},
+            {"std::sort", [](std::vector<int> &v, std::less<int> comp) { std::sort(v.begin(), v.end(), comp); }},
+            {"parallel std::sort", [](std::vector<int> &v, std::less<int>) {
+                size_t grain = (v.size() + Parallel::defaultScheduler().concurrency() - 1) /
+                               Parallel::defaultScheduler().concurrency();
+                parallel_std_sort(v, 0, v.size(), std::max<size_t>(grain, 4096));
+            }},
+            {"parallel_radix_sort", [](std::vector<int> &v, std::less<int>) { parallel_radix_sort(v); }},
+            {"auto_sort", [](std::vector<int> &v, std::less<int> comp) { auto_sort(v, comp); }}};
+
+    std::mt19937 rng(281);
+    std::uniform_int_distribution<int> value(0, 1000000000);
+    std::vector<int> random(n);
+    for (auto &x : random) x = value(rng);
+    std::vector<int> sorted = random, reversed;
+    std::sort(sorted.begin(), sorted.end());
+    reversed.assign(sorted.rbegin(), sorted.rend());
+    const std::pair<const char *, const std::vector<int> *> inputs[] = {
+            {"random", &random}, {"sorted", &sorted}, {"reversed", &reversed}};
+
+    Bench::Runner runner;
+    runner.context("n", std::to_string(n));
+    runner.context("threads", std::to_string(Parallel::defaultScheduler().concurrency()));
+    std::vector<int> a;
+    for (auto &input : inputs) {
+        for (auto &sort : sorts) {
+            bool quadratic = sort.second == bubble_sort<int, std::less<int>> ||
+                             sort.second == insertion_sort<int, std::less<int>> ||
+                             sort.second == selection_sort<int, std::less<int>>;
+            if (quadratic && n > QUADRATIC_LIMIT) continue;
+            runner.run(std::string(sort.first) + "/" + input.first, [&]() { a = *input.second; },
+                       [&]() { sort.second(a, std::less<int>()); });
+            if (!std::is_sorted(a.begin(), a.end())) std::printf("%s/%s: NOT SORTED\n", sort.first, input.first);
+        }
+    }
+
+    const std::pair<const char *, StringSort> stringSorts[] = {
+            {"std::sort", [](std::vector<std::string> &v) { std::sort(v.begin(), v.end()); }},
+            {"merge_sort", [](std::vector<std::string> &v) { merge_sort(v, std::less<std::string>()); }},
+            {"multikey_quick_sort", multikey_quick_sort},
+            {"msd_radix_sort", msd_radix_sort},
+            {"lcp_merge_sort", lcp_merge_sort},
+            {"cached_prefix_sort", cached_prefix_sort},
+            {"auto_sort", [](std::vector<std::string> &v) { auto_sort(v); }}};
+    std::vector<std::string> keys = urls(n, rng), b;
+    for (auto &sort : stringSorts) {
+        runner.run(std::string(sort.first) + "/urls", [&]() { b = keys; }, [&]() { sort.second(b); });
+        if (!std::is_sorted(b.begin(), b.end())) std::printf("%s/urls: NOT SORTED\n", sort.first);
+    }
+
+    // many small arrays, doubles so that auto_sort samples and chooses among the comparison sorts
+    std::mt19937 smallRng(281);
+    std::uniform_real_distribution<double> real(0, 1);
+    std::vector<std::vector<double>> smallInput, smallCopy;
+    for (size_t size : {40, 300, 1000}) {
+        smallInput.assign(SMALL_ELEMENTS / size, std::vector<double>(size));
+        for (auto &array : smallInput)
+            for (auto &x : array) x = real(smallRng);
+        std::string input = "/small_" + std::to_string(size);
+        runner.run("std::sort" + input, [&]() { smallCopy = smallInput; }, [&]() {
+            for (auto &array : smallCopy) std::sort(array.begin(), array.end());
+        });
+        runner.run("auto_sort" + input, [&]() { smallCopy = smallInput; }, [&]() {
+            for (auto &array : smallCopy) auto_sort(array);
+        });
+        for (auto &array : smallCopy)
+            if (!std::is_sorted(array.begin(), array.end())) std::printf("auto_sort%s: NOT SORTED\n", input.c_str());
+    }
+
+    // element writes on the random input, for storage where writes cost more than reads
+    const std::pair<const char *, TrackedSort> trackedSorts[] = {
+            {"bubble_sort", bubble_sort<Tracked, std::less<Tracked>>},
+            {"insertion_sort", insertion_sort<Tracked, std::less<Tracked>>},
+            {"selection_sort", selection_sort<Tracked, std::less<Tracked>>},
+            {"merge_sort", merge_sort<Tracked, std::less<Tracked>>},
+            {"quick_sort_extra", quick_sort_extra<Tracked, std::less<Tracked>>},
+            {"quick_sort_inplace", quick_sort_inplace<Tracked, std::less<Tracked>>},
+            {"natural_merge_sort", natural_merge_sort<Tracked, std::less<Tracked>>},
+            {"write_optimal_sort", write_optimal_sort<Tracked, std::less<Tracked>>},
+            {"std::sort", [](std::vector<Tracked> &v, std::less<Tracked> comp) {
+                std::sort(v.begin(), v.end(), comp);
+            }}};
+    std::vector<Tracked> tracked(random.begin(), random.end()), t;
+    std::printf("\n%-40s %14s %12s\n", "writes/random", "writes", "per element");
+    for (auto &sort : trackedSorts) {
+        bool quadratic = sort.second == bubble_sort<Tracked, std::less<Tracked>> ||
+                         sort.second == insertion_sort<Tracked, std::less<Tracked>> ||
+                         sort.second == selection_sort<Tracked, std::less<Tracked>>;
+        if (quadratic && n > QUADRATIC_LIMIT) continue;
+        t = tracked;
+        Tracked::writes = 0;
+        sort.second(t, std::less<Tracked>());
+        std::printf("%-40s %14zu %12.2f\n", sort.first, Tracked::writes,
+                    static_cast<double>(Tracked::writes) / static_cast<double>(std::max<size_t>(n, 1)));
+        runner.context(std::string("writes/") + sort.first, std::to_string(Tracked::writes));
+    }
+    std::printf("\n");
+
+    // a key column with two payload columns: through rows of pairs and back, or zip_sort in place
+    std::vector<int> keyColumn = random, keyCopy;
+    std::vector<double> priceColumn(n), priceCopy;
+    std::vector<int> idColumn(n), idCopy;
+    for (size_t i = 0; i < n; i++) {
+        priceColumn[i] = static_cast<double>(i) / 4;
+        idColumn[i] = static_cast<int>(i);
+    }
+    auto columns = [&]() {
+        keyCopy = keyColumn;
+        priceCopy = priceColumn;
+        idCopy = idColumn;
+    };
+    runner.run("rows + std::stable_sort/columns", columns, [&]() {
+        std::vector<std::pair<int, std::pair<double, int>>> rows(n);
+        for (size_t i = 0; i < n; i++) rows[i] = {keyCopy[i], {priceCopy[i], idCopy[i]}};
+        std::stable_sort(rows.begin(), rows.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+        for (size_t i = 0; i < n; i++) {
+            keyCopy[i] = rows[i].first;
+            priceCopy[i] = rows[i].second.first;
+            idCopy[i] = rows[i].second.second;
+        }
+    });
+    runner.run("zip_sort/columns", columns, [&]() { zip_sort(keyCopy, priceCopy, idCopy); });
+    if (!std::is_sorted(keyCopy.begin(), keyCopy.end())) std::printf("zip_sort/columns: NOT SORTED\n");
+    runner.run("zip_sort_by/columns", columns, [&]() { zip_sort_by(std::less<int>(), keyCopy, priceCopy, idCopy); });
+
+    // 16-byte records in a temporary file, sorted in place through the mapping
+    struct Record {
+        uint64_t key, payload;
+
+        bool operator<(const Record &that) const { return key < that.key; }
+    };
+    char path[] = "/tmp/p1_bench_records_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0) {
+        std::vector<Record> records(n);
+        for (size_t i = 0; i < n; i++) records[i] = {static_cast<uint64_t>(random[i]), i};
+        auto rewrite = [&]() {
+            if (pwrite(fd, records.data(), n * sizeof(Record), 0) != static_cast<ssize_t>(n * sizeof(Record)))
+                std::printf("can not write %s\n", path);
+        };
+        runner.run("sort_record_file<Record>/file", rewrite, [&]() { sort_record_file<Record>(path); });
+        runner.run("sort_record_file(stride)/file", rewrite, [&]() {
+            sort_record_file(path, sizeof(Record), [](const void *a, const void *b) {
+                uint64_t x, y;
+                memcpy(&x, a, sizeof(x));
+                memcpy(&y, b, sizeof(y));
+                return x < y;
+            });
+        });
+        close(fd);
+        unlink(path);
+    }
+
+    if (argc > 2 && !runner.writeJson(argv[2])) {
+        std::fprintf(stderr, "can not write %s\n", argv[2]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,262 @@
+#ifndef VE281P1_RECORD_FILE_HPP
+#define VE281P1_RECORD_FILE_HPP
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sort.hpp"
+
+/**
+ * In-place sorting of files of fixed-size binary records through a shared memory mapping
+ *
+ * The file is mapped read-write and sorted where it lies, the page cache holds the only copy of the data and the
+ * kernel writes the dirty pages back. The sort is a three-way quicksort: a partition pass scans its range with
+ * two sequential streams, so ranges of at least ADVISE_BYTES are advised MADV_SEQUENTIAL while they are
+ * partitioned (read-ahead, early reclaim of pages behind the scan), then MADV_NORMAL again. Typed records hand
+ * smaller ranges to the in-place three-way quicksort of sort.hpp; records of a runtime size are moved with memcpy
+ * through a buffer of one record. Past depth 2 log n a range is finished by heapsort, also in place.
+ */
+namespace record_sort {
+    // partitions of at least this many bytes are advised as sequential scans
+    static constexpr size_t ADVISE_BYTES = size_t(64) << 20;
+    // below this size, insertion sort
+    static constexpr size_t INSERTION_LIMIT = 16;
+
+    /**
+     * A file mapped read-write and shared, unmapped on destruction
+     */
+    class MappedFile {
+    public:
+        /**
+         * @throw std::runtime_error if the file can not be opened or mapped
+         */
+        explicit MappedFile(const std::string &path) {
+            int fd = ::open(path.c_str(), O_RDWR);
+            if (fd < 0) throw std::runtime_error("cannot open " + path);
+            struct stat st;
+            if (fstat(fd, &st) != 0) {
+                ::close(fd);
+                throw std::runtime_error("cannot stat " + path);
+            }
+            length = static_cast<size_t>(st.st_size);
+            if (length > 0) {
+                void *addr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                if (addr == MAP_FAILED) {
+                    ::close(fd);
+                    throw std::runtime_error("cannot mmap " + path);
+                }
+                base = static_cast<unsigned char *>(addr);
+            }
+            ::close(fd);
+        }
+
+        MappedFile(const MappedFile &) = delete;
+
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        ~MappedFile() {
+            if (base != nullptr) munmap(base, length);
+        }
+
+        unsigned char *data() const { return base; }
+
+        size_t size() const { return length; }
+
+        // madvise over the pages covering [begin, begin + bytes)
+        void advise(const void *begin, size_t bytes, int advice) const {
+            if (base == nullptr || bytes == 0) return;
+            static const size_t page = static_cast<size_t>(sysconf(_SC_PAGE_SIZE));
+            uintptr_t first = reinterpret_cast<uintptr_t>(begin) / page * page;
+            uintptr_t last = reinterpret_cast<uintptr_t>(begin) + bytes;
+            madvise(reinterpret_cast<void *>(first), last - first, advice);
+        }
+
+    private:
+        unsigned char *base = nullptr;
+        size_t length = 0;
+    };
+
+    // records of type T, compared by comp
+    template<typename T, typename Compare>
+    class Typed {
+    public:
+        Typed(T *records, Compare &comp) : records(records), comp(comp) {}
+
+        bool less(size_t i, size_t j) const { return comp(records[i], records[j]); }
+
+        void swap(size_t i, size_t j) { std::swap(records[i], records[j]); }
+
+        void setPivot(size_t i) { pivot = records[i]; }
+
+        bool belowPivot(size_t i) const { return comp(records[i], pivot); }
+
+        bool abovePivot(size_t i) const { return comp(pivot, records[i]); }
+
+        const void *address(size_t i) const { return records + i; }
+
+        size_t bytes(size_t n) const { return n * sizeof(T); }
+
+        // ranges that need no advice go to the in-place three-way quicksort of sort.hpp
+        bool finish(size_t first, size_t n, int depth) {
+            adaptive_sort::three_way_quick(records + first, n, comp, depth, nullptr);
+            return true;
+        }
+
+    private:
+        T *records;
+        Compare &comp;
+        T pivot;
+    };
+
+    // records of recordSize bytes, compared by comp(const void *, const void *)
+    template<typename Compare>
+    class Strided {
+    public:
+        Strided(unsigned char *records, size_t recordSize, Compare &comp) :
+                records(records), recordSize(recordSize), comp(comp), pivot(recordSize), buffer(recordSize) {}
+
+        bool less(size_t i, size_t j) const { return comp(at(i), at(j)); }
+
+        void swap(size_t i, size_t j) {
+            if (i == j) return;
+            memcpy(buffer.data(), at(i), recordSize);
+            memcpy(at(i), at(j), recordSize);
+            memcpy(at(j), buffer.data(), recordSize);
+        }
+
+        void setPivot(size_t i) { memcpy(pivot.data(), at(i), recordSize); }
+
+        bool belowPivot(size_t i) const { return comp(at(i), static_cast<const void *>(pivot.data())); }
+
+        bool abovePivot(size_t i) const { return comp(static_cast<const void *>(pivot.data()), at(i)); }
+
+        const void *address(size_t i) const { return at(i); }
+
+        size_t bytes(size_t n) const { return n * recordSize; }
+
+        bool finish(size_t, size_t, int) { return false; }
+
+    private:
+        unsigned char *records;
+        size_t recordSize;
+        Compare &comp;
+        std::vector<unsigned char> pivot, buffer;
+
+        unsigned char *at(size_t i) const { return records + i * recordSize; }
+    };
+
+    template<typename Records>
+    void insertion(Records &r, size_t first, size_t n) {
+        for (size_t i = first + 1; i < first + n; i++)
+            for (size_t j = i; j > first && r.less(j, j - 1); j--) r.swap(j, j - 1);
+    }
+
+    template<typename Records>
+    void sift_down(Records &r, size_t first, size_t root, size_t n) {
+        while (2 * root + 1 < n) {
+            size_t child = 2 * root + 1;
+            if (child + 1 < n && r.less(first + child, first + child + 1)) child++;
+            if (!r.less(first + root, first + child)) return;
+            r.swap(first + root, first + child);
+            root = child;
+        }
+    }
+
+    template<typename Records>
+    void heap_sort(Records &r, size_t first, size_t n) {
+        for (size_t i = n / 2; i-- > 0;) sift_down(r, first, i, n);
+        for (size_t end = n; end-- > 1;) {
+            r.swap(first, first + end);
+            sift_down(r, first, 0, end);
+        }
+    }
+
+    template<typename Records>
+    void quick(Records &r, const MappedFile &file, size_t first, size_t n, int depth) {
+        while (n > INSERTION_LIMIT) {
+            bool advise = r.bytes(n) >= ADVISE_BYTES;
+            if (!advise && r.finish(first, n, depth)) return;
+            if (depth-- == 0) {
+                heap_sort(r, first, n);
+                return;
+            }
+            size_t a = first, b = first + n / 2, c = first + n - 1;
+            if (r.less(b, a)) std::swap(a, b);
+            if (r.less(c, b)) b = r.less(c, a) ? a : c;
+            r.setPivot(b);
+            if (advise) file.advise(r.address(first), r.bytes(n), MADV_SEQUENTIAL);
+            // Dijkstra partition: [first, lt) below, [lt, i) equal, [gt, first + n) above the pivot
+            size_t lt = first, i = first, gt = first + n;
+            while (i < gt) {
+                if (r.belowPivot(i)) r.swap(lt++, i++);
+                else if (r.abovePivot(i)) r.swap(i, --gt);
+                else i++;
+            }
+            if (advise) file.advise(r.address(first), r.bytes(n), MADV_NORMAL);
+            // recurse into the smaller side, loop on the larger one
+            size_t below = lt - first, above = first + n - gt;
+            if (below < above) {
+                quick(r, file, first, below, depth);
+                first = gt;
+                n = above;
+            }
+            else {
+                quick(r, file, gt, above, depth);
+                n = below;
+            }
+        }
+        insertion(r, first, n);
+    }
+
+    inline int depth_limit(size_t n) {
+        int depth = 0;
+        for (; n > 1; n >>= 1) depth += 2;
+        return depth;
+    }
+}
+
+/**
+ * Sort a file of records of type Record in place, through a shared mapping of the file
+ * No copy of the data is made beyond the page cache; not stable.
+ * Time Complexity: O(n log n) comparisons and swaps
+ * @tparam Record trivially copyable record type, the file is a packed array of it
+ * @throw std::runtime_error if the file can not be mapped or its size is not a multiple of sizeof(Record)
+ */
+template<typename Record, typename Compare = std::less<Record>>
+void sort_record_file(const std::string &path, Compare comp = Compare()) {
+    static_assert(std::is_trivially_copyable<Record>::value, "records must be trivially copyable");
+    record_sort::MappedFile file(path);
+    if (file.size() % sizeof(Record) != 0)
+        throw std::runtime_error(path + " is not an array of " + std::to_string(sizeof(Record)) + "-byte records");
+    size_t n = file.size() / sizeof(Record);
+    record_sort::Typed<Record, Compare> records(reinterpret_cast<Record *>(file.data()), comp);
+    record_sort::quick(records, file, 0, n, record_sort::depth_limit(n));
+}
+
+/**
+ * Sort a file of records of recordSize bytes in place, through a shared mapping of the file
+ * No copy of the data is made beyond the page cache and two records of scratch; not stable.
+ * Time Complexity: O(n log n) comparisons and swaps
+ * @param comp comp(const void *a, const void *b), whether record a goes before record b
+ * @throw std::runtime_error if the file can not be mapped or its size is not a multiple of recordSize
+ */
+template<typename Compare>
+void sort_record_file(const std::string &path, size_t recordSize, Compare comp) {
+    if (recordSize == 0) throw std::invalid_argument("record size must be positive");
+    record_sort::MappedFile file(path);
+    if (file.size() % recordSize != 0)
+        throw std::runtime_error(path + " is not an array of " + std::to_string(recordSize) + "-byte records");
+    size_t n = file.size() / recordSize;
+    record_sort::Strided<Compare> records(file.data(), recordSize, comp);
+    record_sort::quick(records, file, 0, n, record_sort::depth_limit(n));
+}
+
+#endif //VE281P1_RECORD_FILE_HPP
\ No newline at end of file
@@ -2,8 +2,20 @@
 #define VE281P1_SORT_HPP
 
 #include <vector>
+#include <string>
+#include <algorithm>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <functional>
+#include <iterator>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include "../common/large_pages.hpp"
+#include "../common/scheduler.hpp"
 
 template<typename T, typename Compare>
 void bubble_sort(std::vector<T> &vector, Compare comp = std::less<T>()) {
@@ -121,4 +133,940 @@ void quick_sort_inplace(std::vector<T> &vector, Compare comp = std::less<T>()) {
     q.clear();
 }
 
+/**
+ * Write-optimal sort: an indirect sort of positions, then every element moved straight to its final place along
+ * the cycles of the permutation
+ * An element is written at most once and only if it is out of place; within a group of equal keys, elements
+ * already inside the group's final range stay. For storage where writes cost far more than reads (persistent
+ * memory, elements expensive to move). Not stable.
+ * Time Complexity: O(n log n) comparisons, at most n element writes plus one temporary per cycle
+ */
+template<typename T, typename Compare>
+void write_optimal_sort(std::vector<T> &vector, Compare comp = std::less<T>()) {
+    size_t n = vector.size();
+    // order[i]: the position of the element that goes to i
+    std::vector<size_t> order(n), group;
+    for (size_t i = 0; i < n; i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return comp(vector[a], vector[b]); });
+    for (size_t first = 0; first < n;) {
+        size_t last = first + 1;
+        while (last < n && !comp(vector[order[first]], vector[order[last]])) last++;
+        if (last - first > 1) {
+            // sources already inside [first, last) keep their place, the others fill the remaining slots
+            group.assign(order.begin() + first, order.begin() + last);
+            std::fill(order.begin() + first, order.begin() + last, n);
+            for (size_t s : group)
+                if (s >= first && s < last) order[s] = s;
+            size_t slot = first;
+            for (size_t s : group) {
+                if (s >= first && s < last) continue;
+                while (order[slot] != n) slot++;
+                order[slot] = s;
+            }
+        }
+        first = last;
+    }
+    // walk every cycle once, order[i] = i marks the placed positions
+    for (size_t start = 0; start < n; start++) {
+        if (order[start] == start) continue;
+        T displaced = std::move(vector[start]);
+        size_t i = start;
+        while (order[i] != start) {
+            size_t j = order[i];
+            vector[i] = std::move(vector[j]);
+            order[i] = i;
+            i = j;
+        }
+        vector[i] = std::move(displaced);
+        order[i] = i;
+    }
+}
+
+/**
+ * Radix sort of integers, or of integer keys carried with their positions, least significant digit first
+ * Every pass reads the array twice: a histogram of the digit per chunk, then a stable scatter into the other
+ * buffer. The chunks are counted and scattered in parallel, their histograms combined by one prefix sum, so each
+ * chunk owns a disjoint slice of every bucket. The scatter stages each bucket in a cache line buffer and writes
+ * whole aligned lines, 256 write streams would otherwise evict each other's partial lines. Passes where every
+ * key has the same digit are skipped.
+ */
+namespace integer_sort {
+    static constexpr unsigned DIGIT_BITS = 8;
+    static constexpr size_t BUCKETS = size_t(1) << DIGIT_BITS;
+    static constexpr size_t LINE_BYTES = 64;
+    // below this size, std::sort
+    static constexpr size_t SMALL_LIMIT = 256;
+    // minimum number of keys per chunk
+    static constexpr size_t CHUNK_MIN = size_t(1) << 16;
+
+    // the key as an unsigned integer of the same order
+    template<typename T>
+    inline typename std::make_unsigned<T>::type key_of(T x) {
+        typedef typename std::make_unsigned<T>::type U;
+        U u = static_cast<U>(x);
+        if (std::is_signed<T>::value) u ^= static_cast<U>(U(1) << (8 * sizeof(T) - 1));
+        return u;
+    }
+
+    template<typename T>
+    inline size_t digit(T x, unsigned shift) { return static_cast<size_t>(key_of(x) >> shift) & (BUCKETS - 1); }
+
+    // an integer key carried with its original position, sorted by the key alone
+    template<typename K>
+    struct Indexed {
+        K key;
+        uint32_t index;
+    };
+
+    template<typename K>
+    inline size_t digit(const Indexed<K> &x, unsigned shift) { return digit(x.key, shift); }
+
+    template<typename T>
+    struct Key {
+        typedef T type;
+    };
+
+    template<typename K>
+    struct Key<Indexed<K>> {
+        typedef K type;
+    };
+
+    // the order of the sort, positions break ties so that std::sort of small inputs is stable as well
+    template<typename T>
+    inline bool before(T a, T b) { return a < b; }
+
+    template<typename K>
+    inline bool before(const Indexed<K> &a, const Indexed<K> &b) {
+        return a.key < b.key || (a.key == b.key && a.index < b.index);
+    }
+
+    template<typename T>
+    inline void histogram(const T *in, size_t n, unsigned shift, size_t *count) {
+        std::fill(count, count + BUCKETS, 0);
+        for (size_t i = 0; i < n; i++) count[digit(in[i], shift)]++;
+    }
+
+    // scatter in[0, n) to out by digit, offset[d] the next position of digit d
+    template<typename T>
+    void scatter(const T *in, size_t n, unsigned shift, size_t *offset, T *out) {
+        static constexpr size_t LINE = LINE_BYTES / sizeof(T);
+        alignas(LINE_BYTES) T line[BUCKETS][LINE];
+        // line[d][begin[d], fill[d]) are pending, fill[d] is the position in its cache line of the next output
+        uint8_t begin[BUCKETS], fill[BUCKETS];
+        for (size_t d = 0; d < BUCKETS; d++) {
+            uintptr_t address = reinterpret_cast<uintptr_t>(out + offset[d]);
+            begin[d] = fill[d] = static_cast<uint8_t>(address % LINE_BYTES / sizeof(T));
+        }
+        for (size_t i = 0; i < n; i++) {
+            size_t d = digit(in[i], shift);
+            line[d][fill[d]++] = in[i];
+            if (fill[d] == LINE) {
+                memcpy(out + offset[d], line[d] + begin[d], (LINE - begin[d]) * sizeof(T));
+                offset[d] += LINE - begin[d];
+                begin[d] = fill[d] = 0;
+            }
+        }
+        for (size_t d = 0; d < BUCKETS; d++) {
+            memcpy(out + offset[d], line[d] + begin[d], (fill[d] - begin[d]) * sizeof(T));
+            offset[d] += fill[d] - begin[d];
+        }
+    }
+
+    // uninitialized scratch array, first touched by the chunks that scatter into it
+    template<typename T>
+    class Scratch {
+    public:
+        explicit Scratch(size_t n) : n(n), data(static_cast<T *>(LargePages::allocate(n * sizeof(T), LINE_BYTES))) {}
+
+        Scratch(const Scratch &) = delete;
+
+        Scratch &operator=(const Scratch &) = delete;
+
+        ~Scratch() { LargePages::deallocate(data, n * sizeof(T)); }
+
+        T *get() const { return data; }
+
+    private:
+        size_t n;
+        T *data;
+    };
+
+    // body(c) for every chunk c, on the scheduler if there is one
+    template<typename Body>
+    void for_each_chunk(size_t chunks, Body &&body, Parallel::Scheduler *scheduler) {
+        if (scheduler == nullptr || chunks == 1) {
+            for (size_t c = 0; c < chunks; c++) body(c);
+            return;
+        }
+        Parallel::forRange<size_t>(0, chunks, 1, [&](size_t first, size_t last) {
+            for (size_t c = first; c < last; c++) body(c);
+        }, *scheduler);
+    }
+
+    // one chunk per worker of the scheduler, a single chunk without one
+    template<typename T>
+    void lsd(std::vector<T> &vector, Parallel::Scheduler *scheduler) {
+        typedef typename Key<T>::type K;
+        static_assert(std::is_integral<K>::value && !std::is_same<K, bool>::value, "radix sort needs integer keys");
+        size_t n = vector.size();
+        if (n < SMALL_LIMIT) {
+            std::sort(vector.begin(), vector.end(), [](const T &a, const T &b) { return before(a, b); });
+            return;
+        }
+        size_t workers = scheduler != nullptr ? scheduler->concurrency() : 1;
+        size_t chunks = std::max<size_t>(1, std::min<size_t>(workers, n / CHUNK_MIN));
+        size_t per = (n + chunks - 1) / chunks;
+        Scratch<T> scratch(n);
+        std::vector<size_t> count(chunks * BUCKETS);
+        T *from = vector.data(), *to = scratch.get();
+        for (unsigned shift = 0; shift < 8 * sizeof(K); shift += DIGIT_BITS) {
+            for_each_chunk(chunks, [&](size_t c) {
+                histogram(from + c * per, std::min(n, (c + 1) * per) - c * per, shift, &count[c * BUCKETS]);
+            }, scheduler);
+            bool trivial = false;
+            for (size_t d = 0; d < BUCKETS && !trivial; d++) {
+                size_t total = 0;
+                for (size_t c = 0; c < chunks; c++) total += count[c * BUCKETS + d];
+                trivial = total == n;
+            }
+            if (trivial) continue;
+            // chunk c writes digit d after every smaller digit and after digit d of the chunks before it, so the
+            // scatter is stable
+            size_t sum = 0;
+            for (size_t d = 0; d < BUCKETS; d++) {
+                for (size_t c = 0; c < chunks; c++) {
+                    size_t k = count[c * BUCKETS + d];
+                    count[c * BUCKETS + d] = sum;
+                    sum += k;
+                }
+            }
+            for_each_chunk(chunks, [&](size_t c) {
+                scatter(from + c * per, std::min(n, (c + 1) * per) - c * per, shift, &count[c * BUCKETS], to);
+            }, scheduler);
+            std::swap(from, to);
+        }
+        if (from != vector.data()) {
+            for_each_chunk(chunks, [&](size_t c) {
+                memcpy(vector.data() + c * per, from + c * per, (std::min(n, (c + 1) * per) - c * per) * sizeof(T));
+            }, scheduler);
+        }
+    }
+}
+
+/**
+ * LSD radix sort of integers in ascending order
+ * Time Complexity: O(n * sizeof(T))
+ */
+template<typename T>
+void radix_sort(std::vector<T> &vector) {
+    integer_sort::lsd(vector, nullptr);
+}
+
+/**
+ * Parallel LSD radix sort of integers in ascending order
+ * Time Complexity: O(n * sizeof(T)) work, O(n * sizeof(T) / p) time on p workers
+ * @param scheduler scheduler that runs the chunks, one chunk per worker
+ */
+template<typename T>
+void parallel_radix_sort(std::vector<T> &vector, Parallel::Scheduler &scheduler = Parallel::defaultScheduler()) {
+    integer_sort::lsd(vector, &scheduler);
+}
+
+/**
+ * Sorting of std::string by bytes (the order of std::less<std::string>)
+ * Comparison sorts re-compare the common prefix of two strings on every comparison, so on keys with long shared
+ * prefixes (URLs, log keys) they spend most of their time there. The sorts below look at every character of the
+ * distinguishing prefixes a bounded number of times instead. All of them sort an array of pointers and move
+ * every string once at the end. The pointer and scratch arrays come from LargePages::Allocator, so that for
+ * large inputs they follow LargePages::defaultPolicy() onto huge pages.
+ */
+namespace string_sort {
+    typedef std::string *Ptr;
+
+    template<typename T>
+    using Buffer = std::vector<T, LargePages::Allocator<T>>;
+
+    // below this size, buckets and partitions are finished by insertion sort
+    static constexpr size_t INSERTION_LIMIT = 16;
+    // below this size, MSD radix sort hands a bucket to multikey quicksort
+    static constexpr size_t RADIX_LIMIT = 64;
+
+    // character at depth as 0..255, -1 past the end
+    inline int char_at(const std::string &s, size_t depth) {
+        return depth < s.size() ? static_cast<unsigned char>(s[depth]) : -1;
+    }
+
+    // compare two strings known to share their first depth characters
+    inline int compare_from(const std::string &a, const std::string &b, size_t depth) {
+        size_t la = a.size() - depth, lb = b.size() - depth;
+        int c = memcmp(a.data() + depth, b.data() + depth, std::min(la, lb));
+        if (c != 0) return c;
+        return la < lb ? -1 : la > lb ? 1 : 0;
+    }
+
+    // length of the common prefix of a and b, which share their first depth characters
+    inline size_t lcp_from(const std::string &a, const std::string &b, size_t depth) {
+        size_t n = std::min(a.size(), b.size());
+        while (depth < n && a[depth] == b[depth]) depth++;
+        return depth;
+    }
+
+    // length of the common prefix of a[0, n), which share their first depth characters
+    inline size_t common_prefix(const Ptr *a, size_t n, size_t depth) {
+        const std::string &first = *a[0];
+        size_t h = first.size();
+        for (size_t i = 1; i < n && h > depth; i++) {
+            const std::string &s = *a[i];
+            size_t k = depth, end = std::min(h, s.size());
+            while (k < end && s[k] == first[k]) k++;
+            h = k;
+        }
+        return h;
+    }
+
+    inline void insertion_sort(Ptr *a, size_t n, size_t depth) {
+        for (size_t i = 1; i < n; i++) {
+            Ptr x = a[i];
+            size_t j = i;
+            for (; j > 0 && compare_from(*a[j - 1], *x, depth) > 0; j--) a[j] = a[j - 1];
+            a[j] = x;
+        }
+    }
+
+    // move the strings into the order of the pointers
+    inline void apply(std::vector<std::string> &vector, Buffer<Ptr> &order) {
+        std::vector<std::string> sorted;
+        sorted.reserve(vector.size());
+        for (Ptr p : order) sorted.push_back(std::move(*p));
+        vector.swap(sorted);
+    }
+
+    inline Buffer<Ptr> pointers(std::vector<std::string> &vector) {
+        Buffer<Ptr> order(vector.size());
+        for (size_t i = 0; i < vector.size(); i++) order[i] = &vector[i];
+        return order;
+    }
+
+    // Bentley-Sedgewick: three-way partition on the character at depth, only the equal part goes one deeper
+    inline void multikey(Ptr *a, size_t n, size_t depth) {
+        while (n > INSERTION_LIMIT) {
+            int x = char_at(*a[0], depth), y = char_at(*a[n / 2], depth), z = char_at(*a[n - 1], depth);
+            int v = std::max(std::min(x, y), std::min(std::max(x, y), z));
+            size_t lt = 0, i = 0, gt = n;
+            while (i < gt) {
+                int c = char_at(*a[i], depth);
+                if (c < v) std::swap(a[lt++], a[i++]);
+                else if (c > v) std::swap(a[i], a[--gt]);
+                else i++;
+            }
+            if (lt == 0 && gt == n) {
+                // one character for all: skip the whole common prefix in one pass instead of one per character
+                if (v < 0) return;
+                depth = common_prefix(a, n, depth + 1);
+                continue;
+            }
+            multikey(a, lt, depth);
+            // equal strings that ended are done
+            if (v >= 0) multikey(a + lt, gt - lt, depth + 1);
+            a += gt;
+            n -= gt;
+        }
+        insertion_sort(a, n, depth);
+    }
+
+    // MSD radix sort on the character at depth, 256 buckets plus one for strings that ended
+    inline void msd_radix(Ptr *a, size_t n, size_t depth, Ptr *buffer, uint16_t *chars) {
+        if (n < RADIX_LIMIT) {
+            multikey(a, n, depth);
+            return;
+        }
+        size_t count[257] = {};
+        for (size_t i = 0; i < n; i++) {
+            chars[i] = static_cast<uint16_t>(char_at(*a[i], depth) + 1);
+            count[chars[i]]++;
+        }
+        if (count[chars[0]] == n) {
+            // one bucket: skip the whole common prefix
+            if (chars[0] > 0) msd_radix(a, n, common_prefix(a, n, depth + 1), buffer, chars);
+            return;
+        }
+        size_t start[258];
+        start[0] = 0;
+        for (int c = 0; c < 257; c++) start[c + 1] = start[c] + count[c];
+        for (size_t i = 0; i < n; i++) buffer[start[chars[i]]++] = a[i];
+        std::copy(buffer, buffer + n, a);
+        size_t first = count[0];
+        for (int c = 1; c < 257; c++) {
+            if (count[c] > 1) msd_radix(a + first, count[c], depth + 1, buffer, chars);
+            first += count[c];
+        }
+    }
+
+    /**
+     * Merge sorted runs a and b, where lcp_a[i] is the common prefix length of a[i - 1] and a[i] (likewise for b),
+     * into out with the same lcp array
+     * The common prefix of each head with the last output string decides most steps without looking at the
+     * strings; only when they are equal are characters compared, from that depth on
+     */
+    inline void lcp_merge(const Ptr *a, const size_t *lcp_a, size_t na, const Ptr *b, const size_t *lcp_b,
+                          size_t nb, Ptr *out, size_t *lcp_out) {
+        size_t i = 0, j = 0, k = 0, ha = 0, hb = 0;
+        while (i < na && j < nb) {
+            if (ha > hb) {
+                lcp_out[k] = ha;
+                out[k++] = a[i++];
+                if (i < na) ha = lcp_a[i];
+            }
+            else if (ha < hb) {
+                lcp_out[k] = hb;
+                out[k++] = b[j++];
+                if (j < nb) hb = lcp_b[j];
+            }
+            else {
+                size_t h = lcp_from(*a[i], *b[j], ha);
+                bool a_first = h == a[i]->size() || (h < b[j]->size() &&
+                                                     static_cast<unsigned char>((*a[i])[h]) <
+                                                     static_cast<unsigned char>((*b[j])[h]));
+                lcp_out[k] = ha;
+                if (a_first) {
+                    out[k++] = a[i++];
+                    hb = h;
+                    if (i < na) ha = lcp_a[i];
+                }
+                else {
+                    out[k++] = b[j++];
+                    ha = h;
+                    if (j < nb) hb = lcp_b[j];
+                }
+            }
+        }
+        if (i < na) {
+            lcp_out[k] = ha;
+            out[k++] = a[i++];
+            for (; i < na; i++, k++) {
+                lcp_out[k] = lcp_a[i];
+                out[k] = a[i];
+            }
+        }
+        if (j < nb) {
+            lcp_out[k] = hb;
+            out[k++] = b[j++];
+            for (; j < nb; j++, k++) {
+                lcp_out[k] = lcp_b[j];
+                out[k] = b[j];
+            }
+        }
+    }
+
+    // sort a[0, n) and fill lcp[1, n), with scratch space of n pointers and n lcps
+    inline void lcp_merge_sort(Ptr *a, size_t *lcp, size_t n, Ptr *buffer, size_t *lcp_buffer) {
+        if (n <= INSERTION_LIMIT) {
+            insertion_sort(a, n, 0);
+            for (size_t i = 1; i < n; i++) lcp[i] = lcp_from(*a[i - 1], *a[i], 0);
+            if (n > 0) lcp[0] = 0;
+            return;
+        }
+        size_t mid = n / 2;
+        lcp_merge_sort(a, lcp, mid, buffer, lcp_buffer);
+        lcp_merge_sort(a + mid, lcp + mid, n - mid, buffer, lcp_buffer);
+        lcp_merge(a, lcp, mid, a + mid, lcp + mid, n - mid, buffer, lcp_buffer);
+        std::copy(buffer, buffer + n, a);
+        std::copy(lcp_buffer, lcp_buffer + n, lcp);
+    }
+
+    /**
+     * A string with its next 8 characters from the current depth cached as a big-endian integer, so that they
+     * compare as one number, and how many of those 8 characters exist
+     */
+    struct Cached {
+        uint64_t key;
+        uint32_t length;
+        Ptr string;
+
+        void load(size_t depth) {
+            size_t rest = depth < string->size() ? string->size() - depth : 0;
+            length = static_cast<uint32_t>(std::min<size_t>(rest, 8));
+            unsigned char bytes[8] = {};
+            memcpy(bytes, string->data() + std::min(depth, string->size()), length);
+            key = 0;
+            for (int i = 0; i < 8; i++) key = key << 8 | bytes[i];
+        }
+
+        bool less(const Cached &that) const {
+            return key < that.key || (key == that.key && length < that.length);
+        }
+
+        bool same(const Cached &that) const { return key == that.key && length == that.length; }
+    };
+
+    // multikey quicksort with 8-character keys, every element of a has its key loaded for depth
+    inline void cached_multikey(Cached *a, size_t n, size_t depth) {
+        while (n > INSERTION_LIMIT) {
+            Cached x = a[0], y = a[n / 2], z = a[n - 1];
+            if (y.less(x)) std::swap(x, y);
+            if (z.less(y)) y = x.less(z) ? z : x;
+            const Cached v = y;
+            size_t lt = 0, i = 0, gt = n;
+            while (i < gt) {
+                if (a[i].less(v)) std::swap(a[lt++], a[i++]);
+                else if (v.less(a[i])) std::swap(a[i], a[--gt]);
+                else i++;
+            }
+            cached_multikey(a, lt, depth);
+            // a full key means the equal strings may go on
+            if (v.length == 8) {
+                for (size_t k = lt; k < gt; k++) a[k].load(depth + 8);
+                cached_multikey(a + lt, gt - lt, depth + 8);
+            }
+            a += gt;
+            n -= gt;
+        }
+        for (size_t i = 1; i < n; i++) {
+            Cached x = a[i];
+            size_t j = i;
+            for (; j > 0; j--) {
+                // equal full keys are decided by the rest of the strings
+                if (!(x.less(a[j - 1]) || (x.same(a[j - 1]) && x.length == 8 &&
+                                           compare_from(*x.string, *a[j - 1].string, depth + 8) < 0)))
+                    break;
+                a[j] = a[j - 1];
+            }
+            a[j] = x;
+        }
+    }
+}
+
+/**
+ * Multikey quicksort (three-way radix quicksort)
+ * Time Complexity: O(D + n log n) expected character comparisons, D the total length of the distinguishing prefixes
+ */
+inline void multikey_quick_sort(std::vector<std::string> &vector) {
+    string_sort::Buffer<string_sort::Ptr> order = string_sort::pointers(vector);
+    string_sort::multikey(order.data(), order.size(), 0);
+    string_sort::apply(vector, order);
+}
+
+/**
+ * MSD radix sort, small buckets finished by multikey quicksort
+ * Time Complexity: O(D + n log 256), D the total length of the distinguishing prefixes
+ */
+inline void msd_radix_sort(std::vector<std::string> &vector) {
+    string_sort::Buffer<string_sort::Ptr> order = string_sort::pointers(vector), buffer(vector.size());
+    string_sort::Buffer<uint16_t> chars(vector.size());
+    string_sort::msd_radix(order.data(), order.size(), 0, buffer.data(), chars.data());
+    string_sort::apply(vector, order);
+}
+
+/**
+ * LCP-aware merge sort: merges carry the longest common prefixes of neighbours, so a character is compared
+ * at most once per level beyond the prefix shared with the previous output
+ * Time Complexity: O(D + n log n), D the total length of the distinguishing prefixes
+ */
+inline void lcp_merge_sort(std::vector<std::string> &vector) {
+    size_t n = vector.size();
+    string_sort::Buffer<string_sort::Ptr> order = string_sort::pointers(vector), buffer(n);
+    string_sort::Buffer<size_t> lcp(n), lcp_buffer(n);
+    string_sort::lcp_merge_sort(order.data(), lcp.data(), n, buffer.data(), lcp_buffer.data());
+    string_sort::apply(vector, order);
+}
+
+/**
+ * Multikey quicksort on 8 characters at a time, cached next to the pointer as one integer,
+ * so that partitioning never dereferences the strings
+ * Time Complexity: O(D / 8 + n log n) expected key comparisons, D the total length of the distinguishing prefixes
+ */
+inline void cached_prefix_sort(std::vector<std::string> &vector) {
+    string_sort::Buffer<string_sort::Cached> cached(vector.size());
+    for (size_t i = 0; i < vector.size(); i++) {
+        cached[i].string = &vector[i];
+        cached[i].load(0);
+    }
+    string_sort::cached_multikey(cached.data(), cached.size(), 0);
+    string_sort::Buffer<string_sort::Ptr> order(vector.size());
+    for (size_t i = 0; i < vector.size(); i++) order[i] = cached[i].string;
+    string_sort::apply(vector, order);
+}
+
+// the quick sorts of strings in byte order go through multikey quicksort
+template<>
+inline void quick_sort_extra(std::vector<std::string> &vector, std::less<std::string>) {
+    multikey_quick_sort(vector);
+}
+
+template<>
+inline void quick_sort_inplace(std::vector<std::string> &vector, std::less<std::string>) {
+    multikey_quick_sort(vector);
+}
+
+/**
+ * Input statistics and algorithm chosen by auto_sort
+ */
+struct SortDecision {
+    enum Algorithm { INSERTION, NATURAL_MERGE, INTROSORT, THREE_WAY_QUICK, RADIX };
+
+    size_t n = 0;
+    size_t elementSize = 0;
+    double runs = 1;            // estimated number of non-decreasing or non-increasing runs
+    // from a sample of about sqrt(n) keys, taken only when the runs and the type leave introsort and three-way
+    // quicksort to choose from; -1 otherwise
+    double inversions = -1;     // fraction of sampled pairs out of order, 0 sorted, 0.5 random, 1 reversed
+    double distinct = -1;       // fraction of distinct keys in the sample
+    bool parallel = false;      // whether the sort runs on the default scheduler
+    Algorithm algorithm = INSERTION;
+
+    static const char *name(Algorithm algorithm) {
+        static const char *const NAMES[] = {"insertion", "natural_merge", "introsort", "three_way_quick", "radix"};
+        return NAMES[algorithm];
+    }
+};
+
+namespace adaptive_sort {
+    // below this size, insertion sort
+    static constexpr size_t INSERTION_LIMIT = 32;
+    // runs shorter than this are extended by insertion sort before merging
+    static constexpr size_t MIN_RUN = 32;
+    // below this size, comparison sorts beat a radix sort of integers
+    static constexpr size_t RADIX_MIN = 1024;
+    // inputs of at least this many bytes are sorted in parallel when there are several hardware threads
+    static constexpr size_t PARALLEL_BYTES = size_t(4) << 20;
+    // partitions of at least this many elements are sorted as parallel tasks
+    static constexpr size_t FORK_LIMIT = size_t(1) << 14;
+    // most elements in the cardinality sample, which takes about sqrt(n)
+    static constexpr size_t SAMPLE = 256;
+    // adjacent pairs looked at to estimate the runs, a quarter of them in smaller inputs
+    static constexpr size_t SAMPLE_PAIRS = 1024;
+
+    template<typename T, typename Compare>
+    void insertion(T *a, size_t n, Compare &comp) {
+        for (size_t i = 1; i < n; i++) {
+            if (!comp(a[i], a[i - 1])) continue;
+            T x = std::move(a[i]);
+            size_t j = i;
+            for (; j > 0 && comp(x, a[j - 1]); j--) a[j] = std::move(a[j - 1]);
+            a[j] = std::move(x);
+        }
+    }
+
+    // Dijkstra three-way partition around a median of three, ties end up in the middle and are done;
+    // falls back to std::sort past depth 2 log n, and forks the two sides of large partitions to the scheduler
+    template<typename T, typename Compare>
+    void three_way_quick(T *a, size_t n, Compare &comp, int depth, Parallel::Scheduler *scheduler) {
+        while (n > INSERTION_LIMIT) {
+            if (depth-- == 0) {
+                std::sort(a, a + n, comp);
+                return;
+            }
+            T x = a[0], y = a[n / 2], z = a[n - 1];
+            if (comp(y, x)) std::swap(x, y);
+            if (comp(z, y)) y = comp(z, x) ? x : z;
+            T pivot = y;
+            size_t lt = 0, i = 0, gt = n;
+            while (i < gt) {
+                if (comp(a[i], pivot)) std::swap(a[lt++], a[i++]);
+                else if (comp(pivot, a[i])) std::swap(a[i], a[--gt]);
+                else i++;
+            }
+            if (scheduler != nullptr && lt >= FORK_LIMIT && n - gt >= FORK_LIMIT) {
+                Parallel::invoke([&]() { three_way_quick(a, lt, comp, depth, scheduler); },
+                                 [&]() { three_way_quick(a + gt, n - gt, comp, depth, scheduler); }, *scheduler);
+                return;
+            }
+            // recurse into the smaller side, loop on the larger one
+            if (lt < n - gt) {
+                three_way_quick(a, lt, comp, depth, scheduler);
+                a += gt;
+                n -= gt;
+            }
+            else {
+                three_way_quick(a + gt, n - gt, comp, depth, scheduler);
+                n = lt;
+            }
+        }
+        insertion(a, n, comp);
+    }
+
+    // std::thread::hardware_concurrency reads sysfs on every call
+    inline unsigned hardware_threads() {
+        static const unsigned threads = std::thread::hardware_concurrency();
+        return threads;
+    }
+
+    // bottom-up merge sort of keys, returns the number of inverted pairs
+    template<typename T, typename Compare>
+    size_t merge_count(std::vector<T> &keys, Compare &comp) {
+        size_t m = keys.size(), inverted = 0;
+        std::vector<T> buffer(keys);
+        for (size_t width = 1; width < m; width *= 2) {
+            for (size_t first = 0; first < m; first += 2 * width) {
+                size_t mid = std::min(m, first + width), last = std::min(m, first + 2 * width);
+                size_t i = first, j = mid, k = first;
+                while (i < mid && j < last) {
+                    if (comp(keys[j], keys[i])) {
+                        inverted += mid - i;
+                        buffer[k++] = std::move(keys[j++]);
+                    }
+                    else {
+                        buffer[k++] = std::move(keys[i++]);
+                    }
+                }
+                while (i < mid) buffer[k++] = std::move(keys[i++]);
+                while (j < last) buffer[k++] = std::move(keys[j++]);
+            }
+            keys.swap(buffer);
+        }
+        return inverted;
+    }
+
+    // n, the element size and the runs, from min(n / 4, SAMPLE_PAIRS) evenly spaced adjacent pairs
+    template<typename T, typename Compare>
+    SortDecision sample_runs(const std::vector<T> &vector, Compare &comp) {
+        SortDecision d;
+        size_t n = d.n = vector.size();
+        d.elementSize = sizeof(T);
+        if (n < INSERTION_LIMIT) return d;
+        // descents among evenly spaced adjacent pairs, one run starts after each
+        size_t pairs = std::min(n / 4, SAMPLE_PAIRS), descents = 0;
+        // i = k (n - 1) / pairs, stepped without a division per pair
+        size_t step = (n - 1) / pairs, extra = (n - 1) % pairs, carry = 0;
+        for (size_t k = 0, i = 0; k < pairs; k++) {
+            descents += comp(vector[i + 1], vector[i]) ? 1 : 0;
+            i += step;
+            carry += extra;
+            if (carry >= pairs) {
+                carry -= pairs;
+                i++;
+            }
+        }
+        double descentRatio = static_cast<double>(descents) / static_cast<double>(pairs);
+        // descending runs count once as well
+        d.runs = 1 + std::min(descentRatio, 1 - descentRatio) * static_cast<double>(n - 1);
+        return d;
+    }
+
+    // inversions and distinct keys among about sqrt(n), at most SAMPLE, evenly spaced elements in input order;
+    // O(sqrt(n) log n) comparisons, small against the sort it decides on
+    template<typename T, typename Compare>
+    void sample_keys(const std::vector<T> &vector, Compare &comp, SortDecision &d) {
+        size_t n = vector.size();
+        size_t m = std::max<size_t>(2, std::min(SAMPLE, static_cast<size_t>(std::sqrt(static_cast<double>(n)))));
+        if (n < m) return;
+        std::vector<T> keys;
+        keys.reserve(m);
+        for (size_t k = 0; k < m; k++) keys.push_back(vector[k * (n - 1) / (m - 1)]);
+        size_t inverted = merge_count(keys, comp);
+        d.inversions = static_cast<double>(inverted) / (static_cast<double>(m) * static_cast<double>(m - 1) / 2);
+        size_t distinct = 1;
+        for (size_t i = 1; i < m; i++)
+            if (comp(keys[i - 1], keys[i])) distinct++;
+        d.distinct = static_cast<double>(distinct) / static_cast<double>(m);
+    }
+}
+
+/**
+ * Natural merge sort: merges the non-decreasing and non-increasing runs already in the input, runs shorter than
+ * MIN_RUN extended by insertion sort first; stable
+ * Time Complexity: O(n log r), r the number of runs, O(n) on sorted or reversed input
+ */
+template<typename T, typename Compare>
+void natural_merge_sort(std::vector<T> &vector, Compare comp = std::less<T>()) {
+    size_t n = vector.size();
+    if (n <= 1) return;
+    std::vector<size_t> bounds{0};
+    for (size_t first = 0; first < n;) {
+        size_t last = first + 1;
+        if (last < n && comp(vector[last], vector[first])) {
+            // a non-increasing run, reversing it reverses every group of equal keys too, so those are turned back
+            while (last < n && !comp(vector[last - 1], vector[last])) last++;
+            std::reverse(vector.begin() + first, vector.begin() + last);
+            for (size_t i = first; i < last;) {
+                size_t j = i + 1;
+                while (j < last && !comp(vector[i], vector[j])) j++;
+                std::reverse(vector.begin() + i, vector.begin() + j);
+                i = j;
+            }
+        }
+        else {
+            while (last < n && !comp(vector[last], vector[last - 1])) last++;
+        }
+        if (last - first < adaptive_sort::MIN_RUN) {
+            last = std::min(n, first + adaptive_sort::MIN_RUN);
+            adaptive_sort::insertion(vector.data() + first, last - first, comp);
+        }
+        bounds.push_back(first = last);
+    }
+    std::vector<T> buffer;
+    buffer.reserve(n);
+    while (bounds.size() > 2) {
+        std::vector<size_t> merged{0};
+        for (size_t k = 0; k + 1 < bounds.size(); k += 2) {
+            auto first = std::make_move_iterator(vector.begin() + bounds[k]);
+            auto mid = std::make_move_iterator(vector.begin() + bounds[k + 1]);
+            if (k + 2 < bounds.size()) {
+                auto last = std::make_move_iterator(vector.begin() + bounds[k + 2]);
+                std::merge(first, mid, mid, last, std::back_inserter(buffer), comp);
+                merged.push_back(bounds[k + 2]);
+            }
+            else {
+                buffer.insert(buffer.end(), first, mid);
+                merged.push_back(bounds[k + 1]);
+            }
+        }
+        vector.swap(buffer);
+        buffer.clear();
+        bounds.swap(merged);
+    }
+}
+
+/**
+ * Sort after a sampling pass over the input
+ * At most SAMPLE_PAIRS adjacent pairs estimate the runs; with n, the element size and the type they
+ * pick the algorithm, and only the choice between three-way quicksort and introsort also samples the inversions
+ * and the key cardinality, from about sqrt(n) elements:
+ *   insertion sort        fewer than INSERTION_LIMIT elements
+ *   natural merge sort    few runs: sorted, reversed or a concatenation of sorted blocks
+ *   radix sort            integers, or std::string, in the order of std::less
+ *   three-way quicksort   inputs large enough to sort in parallel, or many duplicate keys
+ *   introsort             anything else (std::sort)
+ * Radix sort and three-way quicksort run in parallel on inputs of at least PARALLEL_BYTES bytes.
+ * Time Complexity: O(n log n) worst case, O(n) on sorted or reversed input and for radix sort
+ * @param log optional callback receiving the statistics and the decision before sorting
+ */
+template<typename T, typename Compare = std::less<T>>
+void auto_sort(std::vector<T> &vector, Compare comp = Compare(),
+               const std::function<void(const SortDecision &)> &log = nullptr) {
+    using namespace adaptive_sort;
+    SortDecision d = sample_runs(vector, comp);
+    constexpr bool radix = std::is_same<Compare, std::less<T>>::value &&
+                           ((std::is_integral<T>::value && !std::is_same<T, bool>::value) ||
+                            std::is_same<T, std::string>::value);
+    d.parallel = d.n * d.elementSize >= PARALLEL_BYTES && hardware_threads() > 1;
+    if (d.n < INSERTION_LIMIT) d.algorithm = SortDecision::INSERTION;
+    else if (d.runs <= static_cast<double>(d.n) / MIN_RUN / 2) d.algorithm = SortDecision::NATURAL_MERGE;
+    else if (radix && d.n >= RADIX_MIN) d.algorithm = SortDecision::RADIX;
+    else if (d.parallel) d.algorithm = SortDecision::THREE_WAY_QUICK;
+    else {
+        sample_keys(vector, comp, d);
+        d.algorithm = d.distinct < 0.5 ? SortDecision::THREE_WAY_QUICK : SortDecision::INTROSORT;
+    }
+    if (d.algorithm != SortDecision::RADIX && d.algorithm != SortDecision::THREE_WAY_QUICK) d.parallel = false;
+    if (d.algorithm == SortDecision::RADIX && std::is_same<T, std::string>::value) d.parallel = false;
+    if (log) log(d);
+
+    switch (d.algorithm) {
+        case SortDecision::INSERTION:
+            insertion(vector.data(), vector.size(), comp);
+            break;
+        case SortDecision::NATURAL_MERGE:
+            natural_merge_sort(vector, comp);
+            break;
+        case SortDecision::RADIX:
+            if constexpr (radix) {
+                if constexpr (std::is_same<T, std::string>::value) msd_radix_sort(vector);
+                else if (d.parallel) parallel_radix_sort(vector, Parallel::defaultScheduler());
+                else radix_sort(vector);
+            }
+            break;
+        case SortDecision::THREE_WAY_QUICK: {
+            int depth = 2 * (64 - __builtin_clzll(static_cast<unsigned long long>(d.n)));
+            three_way_quick(vector.data(), vector.size(), comp, depth,
+                            d.parallel ? &Parallel::defaultScheduler() : nullptr);
+            break;
+        }
+        case SortDecision::INTROSORT:
+            std::sort(vector.begin(), vector.end(), comp);
+            break;
+    }
+}
+
+/**
+ * Sorting of a key vector together with companion vectors of the same length, as columns of one table
+ * The keys are sorted with their original positions, then the columns follow the cycles of that permutation in
+ * place, all columns swapped together. No rows of all columns are built and no column is copied, so the peak
+ * memory is the positions rather than a second table; the cycles are chains of dependent accesses, slower than
+ * gathering into fresh buffers on large columns but without their extra copy of every column.
+ */
+namespace zip_sort_detail {
+    // move the element at position order[i] of every column to position i, in place: each cycle of the
+    // permutation is walked once, swapping the elements of all columns together; one bit per element marks
+    // the positions already placed
+    template<typename Index, typename... C>
+    void permute(const std::vector<Index> &order, std::vector<C> &...columns) {
+        size_t n = order.size();
+        std::vector<bool> placed(n, false);
+        for (size_t start = 0; start < n; start++) {
+            if (placed[start]) continue;
+            // position j receives the element of order[j], the element first at start travels along the cycle
+            size_t j = start;
+            for (size_t k = order[j]; k != start; j = k, k = order[j]) {
+                using std::swap;
+                (swap(columns[j], columns[k]), ...);
+                placed[j] = true;
+            }
+            placed[j] = true;
+        }
+    }
+
+    // stable indirect sort of the key positions, then keys and companions permuted along
+    template<typename Index, typename Compare, typename K, typename... V>
+    void sort_by_position(Compare &comp, std::vector<K> &keys, std::vector<V> &...values) {
+        size_t n = keys.size();
+        std::vector<Index> order(n);
+        for (size_t i = 0; i < n; i++) order[i] = static_cast<Index>(i);
+        natural_merge_sort(order, [&](Index a, Index b) { return comp(keys[a], keys[b]); });
+        permute(order, keys, values...);
+    }
+
+    template<typename K, typename... V>
+    void check_sizes(const std::vector<K> &keys, const std::vector<V> &...values) {
+        if (((values.size() != keys.size()) || ...))
+            throw std::invalid_argument("zip_sort: companion vectors must have as many elements as the keys");
+    }
+}
+
+/**
+ * Stable sort of keys by comp, every companion vector permuted along
+ * Natural merge sort of the key positions, so presorted columns are cheap, then the keys and the companions are
+ * permuted in place together; no column is copied, the extra memory is the positions (32-bit when they fit)
+ * and their merge buffer
+ * Time Complexity: O(n log n) comparisons, O(n) swaps per column
+ * @throw std::invalid_argument if a companion differs in length from the keys
+ */
+template<typename Compare, typename K, typename... V>
+void zip_sort_by(Compare comp, std::vector<K> &keys, std::vector<V> &...values) {
+    zip_sort_detail::check_sizes(keys, values...);
+    if (keys.size() <= UINT32_MAX) zip_sort_detail::sort_by_position<uint32_t>(comp, keys, values...);
+    else zip_sort_detail::sort_by_position<size_t>(comp, keys, values...);
+}
+
+/**
+ * Stable sort of keys in ascending order, every companion vector permuted along
+ * Integer keys go through a radix sort of the keys with 32-bit positions, in parallel on large inputs, and the
+ * companions are permuted in place; other keys through zip_sort_by
+ * Time Complexity: O(n * sizeof(K)) for integer keys, O(n log n) otherwise, O(n) swaps per companion
+ * @throw std::invalid_argument if a companion differs in length from the keys
+ */
+template<typename K, typename... V>
+void zip_sort(std::vector<K> &keys, std::vector<V> &...values) {
+    if constexpr (std::is_integral<K>::value && !std::is_same<K, bool>::value) {
+        zip_sort_detail::check_sizes(keys, values...);
+        size_t n = keys.size();
+        if (n <= UINT32_MAX) {
+            std::vector<integer_sort::Indexed<K>> indexed(n);
+            for (size_t i = 0; i < n; i++) indexed[i] = {keys[i], static_cast<uint32_t>(i)};
+            bool parallel = std::thread::hardware_concurrency() > 1 &&
+                            n * sizeof(integer_sort::Indexed<K>) >= adaptive_sort::PARALLEL_BYTES;
+            integer_sort::lsd(indexed, parallel ? &Parallel::defaultScheduler() : nullptr);
+            std::vector<uint32_t> order(n);
+            for (size_t i = 0; i < n; i++) {
+                keys[i] = indexed[i].key;
+                order[i] = indexed[i].index;
+            }
+            std::vector<integer_sort::Indexed<K>>().swap(indexed);
+            zip_sort_detail::permute(order, values...);
+            return;
+        }
+    }
+    zip_sort_by(std::less<K>(), keys, values...);
+}
+
 #endif //VE281P1_SORT_HPP
\ No newline at end of file
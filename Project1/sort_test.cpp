@@ -0,0 +1,376 @@
+// Tests of the sorting algorithms against std::sort and std::stable_sort, of the record file sorts and of the
+// scheduler they run on
+//
+// Usage: sort_test
+
+#include "sort.hpp"
+#include "record_file.hpp"
+#include "../common/check.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+typedef void (*Sort)(std::vector<int> &, std::less<int>);
+typedef void (*StringSort)(std::vector<std::string> &);
+
+static std::mt19937_64 rng(281);
+
+// random ints in [-range, range], few distinct values when range is small
+static std::vector<int> random_ints(size_t n, int range) {
+    std::uniform_int_distribution<int> value(-range, range);
+    std::vector<int> v(n);
+    for (auto &x : v) x = value(rng);
+    return v;
+}
+
+// the inputs every comparison sort must handle: empty, tiny, random, duplicated, sorted, reversed
+static std::vector<std::vector<int>> int_inputs(size_t n) {
+    std::vector<std::vector<int>> inputs{{}, {7}, {2, 1}, {1, 1, 1}, random_ints(n, 1000000000),
+                                         random_ints(n, 3)};
+    std::vector<int> sorted = random_ints(n, 1000);
+    std::sort(sorted.begin(), sorted.end());
+    inputs.push_back(sorted);
+    std::reverse(sorted.begin(), sorted.end());
+    inputs.push_back(sorted);
+    return inputs;
+}
+
+// strings over a small alphabet with long shared prefixes, and a few empty ones
+static std::vector<std::string> random_strings(size_t n) {
+    const std::string prefixes[] = {"", "http://", "http://www.example.com/", "http://www.example.com/a/b/"};
+    std::uniform_int_distribution<int> prefix(0, 3), length(0, 12), letter('a', 'd');
+    std::vector<std::string> v(n);
+    for (auto &s : v) {
+        s = prefixes[prefix(rng)];
+        for (int k = length(rng); k > 0; k--) s += static_cast<char>(letter(rng));
+    }
+    return v;
+}
+
+struct Row {
+    int key;
+    size_t position;
+};
+
+static bool key_less(const Row &a, const Row &b) { return a.key < b.key; }
+
+static std::vector<Row> random_rows(size_t n, int range) {
+    std::vector<int> keys = random_ints(n, range);
+    std::vector<Row> rows(n);
+    for (size_t i = 0; i < n; i++) rows[i] = {keys[i], i};
+    return rows;
+}
+
+static bool same_rows(const std::vector<Row> &a, const std::vector<Row> &b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const Row &x, const Row &y) {
+        return x.key == y.key && x.position == y.position;
+    });
+}
+
+static void test_comparison_sorts() {
+    const std::pair<const char *, Sort> sorts[] = {
+            {"bubble_sort", bubble_sort<int, std::less<int>>},
+            {"insertion_sort", insertion_sort<int, std::less<int>>},
+            {"selection_sort", selection_sort<int, std::less<int>>},
+            {"merge_sort", merge_sort<int, std::less<int>>},
+            {"quick_sort_extra", quick_sort_extra<int, std::less<int>>},
+            {"quick_sort_inplace", quick_sort_inplace<int, std::less<int>>},
+            {"write_optimal_sort", write_optimal_sort<int, std::less<int>>},
+            {"natural_merge_sort", natural_merge_sort<int, std::less<int>>},
+    };
+    for (const auto &input : int_inputs(1500)) {
+        std::vector<int> expected = input;
+        std::sort(expected.begin(), expected.end());
+        for (const auto &sort : sorts) {
+            std::vector<int> v = input;
+            sort.second(v, std::less<int>());
+            if (v != expected) std::fprintf(stderr, "%s, n = %zu\n", sort.first, input.size());
+            VE281_CHECK(v == expected);
+        }
+    }
+    // a non-default order
+    std::vector<int> v = random_ints(1000, 50), expected = v;
+    std::sort(expected.begin(), expected.end(), std::greater<int>());
+    quick_sort_inplace(v, std::greater<int>());
+    VE281_CHECK(v == expected);
+}
+
+static void test_stable_sorts() {
+    std::vector<Row> input = random_rows(5000, 40), expected = input;
+    std::stable_sort(expected.begin(), expected.end(), key_less);
+    std::vector<Row> merged = input;
+    merge_sort(merged, key_less);
+    VE281_CHECK(same_rows(merged, expected));
+    std::vector<Row> natural = input;
+    natural_merge_sort(natural, key_less);
+    VE281_CHECK(same_rows(natural, expected));
+    // runs of the natural merge sort: ascending and descending stretches, with ties inside the descending ones
+    std::vector<Row> runs;
+    for (size_t i = 0; i < 3000; i++) {
+        int offset = static_cast<int>(i % 500);
+        runs.push_back({offset < 250 ? offset : 500 - offset / 2, i});
+    }
+    expected = runs;
+    std::stable_sort(expected.begin(), expected.end(), key_less);
+    natural_merge_sort(runs, key_less);
+    VE281_CHECK(same_rows(runs, expected));
+}
+
+static void test_radix_sorts() {
+    Parallel::Scheduler scheduler(4);
+    for (size_t n : {0, 1, 1000, 300000}) {
+        std::vector<int> v = random_ints(n, 2000000000), expected = v;
+        std::sort(expected.begin(), expected.end());
+        std::vector<int> parallel = v;
+        radix_sort(v);
+        VE281_CHECK(v == expected);
+        parallel_radix_sort(parallel, scheduler);
+        VE281_CHECK(parallel == expected);
+    }
+    std::vector<uint64_t> wide(100000);
+    for (auto &x : wide) x = rng();
+    std::vector<uint64_t> expected = wide;
+    std::sort(expected.begin(), expected.end());
+    radix_sort(wide);
+    VE281_CHECK(wide == expected);
+    std::vector<int8_t> narrow(5000);
+    for (auto &x : narrow) x = static_cast<int8_t>(rng());
+    std::vector<int8_t> narrow_expected = narrow;
+    std::sort(narrow_expected.begin(), narrow_expected.end());
+    parallel_radix_sort(narrow, scheduler);
+    VE281_CHECK(narrow == narrow_expected);
+}
+
+static void test_string_sorts() {
+    const std::pair<const char *, StringSort> sorts[] = {
+            {"multikey_quick_sort", multikey_quick_sort},
+            {"msd_radix_sort", msd_radix_sort},
+            {"lcp_merge_sort", lcp_merge_sort},
+            {"cached_prefix_sort", cached_prefix_sort},
+    };
+    std::vector<std::vector<std::string>> inputs{{}, {"a"}, {"b", "a", ""}, random_strings(3000),
+                                                 std::vector<std::string>(100, "same")};
+    std::string binary(20, '\0');
+    binary[3] = '\xff';
+    inputs.push_back({binary, std::string(20, '\0'), "\xff", std::string(1, '\0')});
+    for (const auto &input : inputs) {
+        std::vector<std::string> expected = input;
+        std::sort(expected.begin(), expected.end());
+        for (const auto &sort : sorts) {
+            std::vector<std::string> v = input;
+            sort.second(v);
+            if (v != expected) std::fprintf(stderr, "%s, n = %zu\n", sort.first, input.size());
+            VE281_CHECK(v == expected);
+        }
+        std::vector<std::string> v = input;
+        quick_sort_extra(v, std::less<std::string>());
+        VE281_CHECK(v == expected);
+        v = input;
+        quick_sort_inplace(v, std::less<std::string>());
+        VE281_CHECK(v == expected);
+    }
+}
+
+static void test_auto_sort() {
+    std::vector<SortDecision::Algorithm> chosen;
+    auto log = [&](const SortDecision &d) { chosen.push_back(d.algorithm); };
+    for (const auto &input : int_inputs(200000)) {
+        std::vector<int> v = input, expected = input;
+        std::sort(expected.begin(), expected.end());
+        auto_sort(v, std::less<int>(), log);
+        VE281_CHECK(v == expected);
+    }
+    VE281_CHECK(chosen.size() == int_inputs(0).size());
+    std::vector<double> reals(100000);
+    for (auto &x : reals) x = std::uniform_real_distribution<double>(-1, 1)(rng);
+    std::vector<double> expected_reals = reals;
+    std::sort(expected_reals.begin(), expected_reals.end(), std::greater<double>());
+    auto_sort(reals, std::greater<double>());
+    VE281_CHECK(reals == expected_reals);
+    std::vector<std::string> strings = random_strings(20000), expected_strings = strings;
+    std::sort(expected_strings.begin(), expected_strings.end());
+    auto_sort(strings);
+    VE281_CHECK(strings == expected_strings);
+    // many small arrays, where the sampling pass dominates
+    for (size_t n : {2, 40, 300}) {
+        std::vector<int> v = random_ints(n, 100), expected = v;
+        std::sort(expected.begin(), expected.end());
+        auto_sort(v);
+        VE281_CHECK(v == expected);
+    }
+}
+
+static void test_zip_sort() {
+    for (size_t n : {0, 1, 5000, 200000}) {
+        std::vector<int> keys = random_ints(n, 30);
+        std::vector<size_t> positions(n);
+        std::vector<std::string> names(n);
+        for (size_t i = 0; i < n; i++) {
+            positions[i] = i;
+            names[i] = std::to_string(keys[i]);
+        }
+        std::vector<Row> expected;
+        for (size_t i = 0; i < n; i++) expected.push_back({keys[i], i});
+        std::stable_sort(expected.begin(), expected.end(), key_less);
+
+        std::vector<int> k1 = keys;
+        std::vector<size_t> p1 = positions;
+        std::vector<std::string> s1 = names;
+        zip_sort(k1, p1, s1);
+        std::vector<Row> got;
+        for (size_t i = 0; i < n; i++) {
+            got.push_back({k1[i], p1[i]});
+            VE281_CHECK(s1[i] == std::to_string(k1[i]));
+        }
+        VE281_CHECK(same_rows(got, expected));
+
+        std::vector<int> k2 = keys;
+        std::vector<size_t> p2 = positions;
+        zip_sort_by(std::less<int>(), k2, p2);
+        got.clear();
+        for (size_t i = 0; i < n; i++) got.push_back({k2[i], p2[i]});
+        VE281_CHECK(same_rows(got, expected));
+    }
+    // string keys and a descending order, through zip_sort_by
+    std::vector<std::string> keys = random_strings(4000), expected = keys;
+    std::vector<size_t> positions(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) positions[i] = i;
+    std::vector<std::string> original = keys;
+    std::stable_sort(expected.begin(), expected.end(), std::greater<std::string>());
+    zip_sort_by(std::greater<std::string>(), keys, positions);
+    VE281_CHECK(keys == expected);
+    bool aligned = true;
+    for (size_t i = 0; i < keys.size(); i++) aligned &= original[positions[i]] == keys[i];
+    VE281_CHECK(aligned);
+    for (size_t i = 1; i < keys.size(); i++)
+        if (keys[i] == keys[i - 1]) VE281_CHECK(positions[i] > positions[i - 1]);
+
+    std::vector<int> short_keys(3);
+    std::vector<int> long_values(4);
+    VE281_CHECK_THROWS(zip_sort(short_keys, long_values), std::invalid_argument);
+    VE281_CHECK_THROWS(zip_sort_by(std::less<int>(), short_keys, long_values), std::invalid_argument);
+}
+
+struct Record {
+    uint32_t key;
+    uint32_t tag;
+    char payload[8];
+
+    bool operator<(const Record &that) const { return key < that.key; }
+};
+
+static void write_file(const std::string &path, const void *data, size_t bytes) {
+    FILE *file = std::fopen(path.c_str(), "wb");
+    VE281_CHECK(file != nullptr);
+    if (file == nullptr) return;
+    VE281_CHECK(std::fwrite(data, 1, bytes, file) == bytes);
+    std::fclose(file);
+}
+
+static std::vector<char> read_file(const std::string &path) {
+    std::vector<char> data;
+    FILE *file = std::fopen(path.c_str(), "rb");
+    VE281_CHECK(file != nullptr);
+    if (file == nullptr) return data;
+    char buffer[4096];
+    for (size_t got; (got = std::fread(buffer, 1, sizeof(buffer), file)) > 0; )
+        data.insert(data.end(), buffer, buffer + got);
+    std::fclose(file);
+    return data;
+}
+
+static void test_record_files() {
+    const std::string path = "/tmp/ve281_sort_test_" + std::to_string(getpid()) + ".bin";
+    std::vector<Record> records(50000);
+    for (size_t i = 0; i < records.size(); i++) {
+        records[i].key = static_cast<uint32_t>(rng() % 1000);
+        records[i].tag = static_cast<uint32_t>(i);
+        std::snprintf(records[i].payload, sizeof(records[i].payload), "%07u", records[i].tag);
+    }
+    write_file(path, records.data(), records.size() * sizeof(Record));
+    sort_record_file<Record>(path);
+    std::vector<char> data = read_file(path);
+    VE281_CHECK(data.size() == records.size() * sizeof(Record));
+    std::vector<Record> sorted(data.size() / sizeof(Record));
+    std::memcpy(sorted.data(), data.data(), sorted.size() * sizeof(Record));
+    VE281_CHECK(std::is_sorted(sorted.begin(), sorted.end()));
+    // not stable, but every record is kept whole
+    std::vector<bool> seen(records.size(), false);
+    bool whole = true;
+    for (const auto &r : sorted) {
+        whole &= r.tag < records.size() && !seen[r.tag] && r.key == records[r.tag].key &&
+                 std::memcmp(r.payload, records[r.tag].payload, sizeof(r.payload)) == 0;
+        if (r.tag < records.size()) seen[r.tag] = true;
+    }
+    VE281_CHECK(whole);
+
+    // 3-byte records compared as big-endian numbers
+    const size_t size = 3;
+    std::vector<unsigned char> raw(size * 20000);
+    for (auto &c : raw) c = static_cast<unsigned char>(rng() % 7);
+    write_file(path, raw.data(), raw.size());
+    sort_record_file(path, size, [](const void *a, const void *b) { return std::memcmp(a, b, size) < 0; });
+    std::vector<std::string> expected;
+    for (size_t i = 0; i < raw.size(); i += size) expected.emplace_back(reinterpret_cast<char *>(&raw[i]), size);
+    std::sort(expected.begin(), expected.end(), [](const std::string &a, const std::string &b) {
+        return std::memcmp(a.data(), b.data(), size) < 0;
+    });
+    data = read_file(path);
+    VE281_CHECK(data.size() == raw.size());
+    bool equal = data.size() == raw.size();
+    for (size_t i = 0; equal && i < expected.size(); i++)
+        equal = std::memcmp(&data[i * size], expected[i].data(), size) == 0;
+    VE281_CHECK(equal);
+
+    write_file(path, raw.data(), 10);
+    VE281_CHECK_THROWS(sort_record_file<Record>(path), std::runtime_error);
+    VE281_CHECK_THROWS(sort_record_file(path, 0, [](const void *, const void *) { return false; }),
+                       std::invalid_argument);
+    std::remove(path.c_str());
+    VE281_CHECK_THROWS(sort_record_file<Record>(path), std::runtime_error);
+}
+
+static void test_scheduler() {
+    Parallel::Scheduler scheduler(4);
+    VE281_CHECK(scheduler.concurrency() == 4);
+    std::vector<std::atomic<int>> visits(100000);
+    Parallel::forRange<size_t>(0, visits.size(), 64, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) visits[i]++;
+    }, scheduler);
+    bool once = true;
+    for (auto &v : visits) once &= v == 1;
+    VE281_CHECK(once);
+    int left = 0, right = 0;
+    Parallel::invoke([&]() { left = 1; }, [&]() { right = 2; }, scheduler);
+    VE281_CHECK(left == 1 && right == 2);
+    long long sum = Parallel::reduce<long long>(1, 100001, 100, 0LL, [](long long first, long long last) {
+        long long s = 0;
+        for (long long i = first; i < last; i++) s += i;
+        return s;
+    }, [](long long a, long long b) { return a + b; }, scheduler);
+    VE281_CHECK(sum == 100000LL * 100001 / 2);
+    // nested forks from inside a task
+    std::atomic<int> leaves{0};
+    scheduler.run([&]() {
+        Parallel::forRange<int>(0, 1000, 1, [&](int first, int last) { leaves += last - first; }, scheduler);
+    });
+    VE281_CHECK(leaves == 1000);
+}
+
+int main() {
+    Check::run("comparison sorts", test_comparison_sorts);
+    Check::run("stable sorts", test_stable_sorts);
+    Check::run("radix sorts", test_radix_sorts);
+    Check::run("string sorts", test_string_sorts);
+    Check::run("auto_sort", test_auto_sort);
+    Check::run("zip_sort", test_zip_sort);
+    Check::run("record files", test_record_files);
+    Check::run("scheduler", test_scheduler);
+    return Check::report();
+}
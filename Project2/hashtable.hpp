@@ -1,9 +1,11 @@
 #include "hash_prime.hpp"
 
 #include <exception>
+#include <stdexcept>
 #include <functional>
 #include <vector>
 #include <forward_list>
+#include <memory>
 #include <cmath>
 
 /**
@@ -15,17 +17,20 @@
  * @tparam Value        data type
  * @tparam Hash         function object, return the hash value of a key
  * @tparam KeyEqual     function object, return whether two keys are the same
+ * @tparam BucketAllocator  allocator template of the bucket array, LargePages::Allocator puts the buckets of
+ *                          a big table on huge pages, where every lookup would otherwise miss the TLB
  */
 template<
         typename Key, typename Value,
         typename Hash = std::hash<Key>,
-        typename KeyEqual = std::equal_to<Key>
+        typename KeyEqual = std::equal_to<Key>,
+        template<typename> class BucketAllocator = std::allocator
 >
 class HashTable {
 public:
     typedef std::pair<const Key, Value> HashNode;
     typedef std::forward_list<HashNode> HashNodeList;
-    typedef std::vector<HashNodeList> HashTableData;
+    typedef std::vector<HashNodeList, BucketAllocator<HashNodeList>> HashTableData;
 
     /**
      * A single directional iterator for the hashtable
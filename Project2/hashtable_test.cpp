@@ -0,0 +1,147 @@
+// Tests of the hashtable against std::unordered_map: random inserts, lookups and erases, iteration, copies,
+// rehashing and the load factor bound
+//
+// Usage: hashtable_test
+
+#include "hashtable.hpp"
+#include "../common/large_pages.hpp"
+#include "../common/check.hpp"
+
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static std::mt19937_64 rng(281);
+
+// every element of table is in expected with the same value and the other way round, each visited once
+template<typename Table, typename Key, typename Value>
+static bool same_contents(Table &table, const std::unordered_map<Key, Value> &expected) {
+    if (table.size() != expected.size()) return false;
+    size_t visited = 0;
+    for (auto it = table.begin(); it != table.end(); ++it, ++visited) {
+        auto found = expected.find(it->first);
+        if (found == expected.end() || found->second != it->second) return false;
+    }
+    if (visited != expected.size()) return false;
+    for (const auto &kv : expected) {
+        auto it = table.find(kv.first);
+        if (it == table.end() || it->second != kv.second) return false;
+    }
+    return true;
+}
+
+// one random operation in four is an erase, keys drawn from [0, keys) so that they repeat
+template<typename Table>
+static void random_operations(Table &table, std::unordered_map<int, int> &expected, size_t operations, int keys) {
+    std::uniform_int_distribution<int> key(0, keys - 1), kind(0, 3);
+    for (size_t i = 0; i < operations; i++) {
+        int k = key(rng), value = static_cast<int>(rng());
+        switch (kind(rng)) {
+            case 0: {
+                bool existed = expected.count(k) > 0;
+                VE281_CHECK(table.erase(k) == existed);
+                expected.erase(k);
+                break;
+            }
+            case 1:
+                table[k] = value;
+                expected[k] = value;
+                break;
+            default: {
+                bool fresh = expected.count(k) == 0;
+                VE281_CHECK(table.insert(k, value) == fresh);
+                expected[k] = value;
+            }
+        }
+        VE281_CHECK(table.contains(k) == (expected.count(k) > 0));
+    }
+}
+
+static void test_random_operations() {
+    for (int keys : {1, 16, 5000}) {
+        HashTable<int, int> table;
+        std::unordered_map<int, int> expected;
+        random_operations(table, expected, 40000, keys);
+        VE281_CHECK(same_contents(table, expected));
+        VE281_CHECK(table.loadFactor() <= table.getMaxLoadFactor());
+    }
+}
+
+static void test_erase_all() {
+    HashTable<int, int> table;
+    for (int k = 0; k < 1000; k++) VE281_CHECK(table.insert(k, k * k));
+    VE281_CHECK(table.size() == 1000);
+    for (int k = 999; k >= 0; k -= 2) VE281_CHECK(table.erase(k));
+    for (int k = 0; k < 1000; k += 2) VE281_CHECK(table.erase(k));
+    VE281_CHECK(table.size() == 0);
+    VE281_CHECK(!(table.begin() != table.end()));
+    VE281_CHECK(!table.erase(7));
+    // still usable after emptying
+    VE281_CHECK(table.insert(7, 49));
+    VE281_CHECK(table.find(7) != table.end() && table.find(7)->second == 49);
+}
+
+static void test_copies() {
+    HashTable<int, int> table;
+    std::unordered_map<int, int> expected;
+    random_operations(table, expected, 5000, 1000);
+    HashTable<int, int> copy(table);
+    VE281_CHECK(same_contents(copy, expected));
+    HashTable<int, int> assigned;
+    assigned.insert(-1, -1);
+    assigned = table;
+    VE281_CHECK(same_contents(assigned, expected));
+    // the copies are independent of the original
+    std::unordered_map<int, int> before = expected;
+    random_operations(table, expected, 5000, 1000);
+    VE281_CHECK(same_contents(table, expected));
+    VE281_CHECK(same_contents(copy, before));
+    VE281_CHECK(same_contents(assigned, before));
+}
+
+static void test_rehash() {
+    HashTable<int, int> table;
+    std::unordered_map<int, int> expected;
+    random_operations(table, expected, 3000, 3000);
+    table.rehash(100000);
+    VE281_CHECK(table.bucketSize() >= 100000);
+    VE281_CHECK(same_contents(table, expected));
+    table.setMaxLoadFactor(4);
+    VE281_CHECK(table.getMaxLoadFactor() == 4);
+    VE281_CHECK(same_contents(table, expected));
+    random_operations(table, expected, 20000, 20000);
+    VE281_CHECK(table.loadFactor() <= 4);
+    VE281_CHECK(same_contents(table, expected));
+    VE281_CHECK_THROWS(table.setMaxLoadFactor(0), std::range_error);
+    VE281_CHECK(table.getMaxLoadFactor() == 4);
+}
+
+static void test_string_keys() {
+    HashTable<std::string, size_t> table(1000);
+    std::unordered_map<std::string, size_t> expected;
+    for (size_t i = 0; i < 20000; i++) {
+        std::string key = "key" + std::to_string(rng() % 5000);
+        table[key] += i;
+        expected[key] += i;
+    }
+    VE281_CHECK(same_contents(table, expected));
+}
+
+static void test_large_page_buckets() {
+    HashTable<int, int, std::hash<int>, std::equal_to<int>, LargePages::Allocator> table;
+    std::unordered_map<int, int> expected;
+    random_operations(table, expected, 200000, 100000);
+    VE281_CHECK(same_contents(table, expected));
+}
+
+int main() {
+    Check::run("random operations", test_random_operations);
+    Check::run("erase everything", test_erase_all);
+    Check::run("copies", test_copies);
+    Check::run("rehash and load factor", test_rehash);
+    Check::run("string keys", test_string_keys);
+    Check::run("large page buckets", test_large_page_buckets);
+    return Check::report();
+}
@@ -3,9 +3,11 @@
 #include <time.h>
 #include <unordered_map>
 #include <list>
-#include <chrono>
+#include <algorithm>
+#include <string>
 #include "copy.hpp"
 #include "hashtable.hpp"
+#include "../common/benchmark.hpp"
 #define ll long long
 #define N 1000010
 
@@ -25,75 +27,78 @@ public:
 
 int x[N], y[N];
 
-int main() {
+// Usage: main [json file], to also write the results as JSON
+int main(int argc, char *argv[]) {
     int n = 100000, m = 10000;
-    srand(static_cast<unsigned int>(time(NULL)));
-    HashTable<size_t, Value> ht;
-    std::unordered_map<size_t, Value> um;
-    std::list<std::pair<size_t, Value>> lst;
-
+    // a fixed workload, so that results of different builds compare the same operations
+    const unsigned int seed = 281;
+    srand(seed);
     for (int i = 0; i < n; i++) {
         x[i] = rand()%3, y[i] = rand()%m;
     }
 
-    auto start1 = std::chrono::steady_clock::now();
-    for (int i = 0; i < n; i++) {
-        if (x[i] == 0) {
-            ht.insert(y[i], Value(i));
-        }
-        if (x[i] == 1) {
-            ht.erase(y[i]);
-        }
-        if (x[i] == 2) {
-            ht[y[i]].val;
-        }
-    }
-    auto end1 = std::chrono::steady_clock::now();
-    auto start2 = std::chrono::steady_clock::now();
-    for (int i = 0; i < n; i++) {
-        if (x[i] == 0) {
-            um[y[i]] = Value(i);
-        }
-        if (x[i] == 1) {
-            um.erase(y[i]);
+    Bench::Runner runner;
+    runner.context("operations", std::to_string(n));
+    runner.context("keys", std::to_string(m));
+    runner.context("seed", std::to_string(seed));
+    runner.run("HashTable", [&]() {
+        HashTable<size_t, Value> ht;
+        for (int i = 0; i < n; i++) {
+            if (x[i] == 0) {
+                ht.insert(y[i], Value(i));
+            }
+            if (x[i] == 1) {
+                ht.erase(y[i]);
+            }
+            if (x[i] == 2) {
+                Bench::doNotOptimize(ht[y[i]].val);
+            }
         }
-        if (x[i] == 2) {
-            um[y[i]].val;
+    });
+    runner.run("unordered_map", [&]() {
+        std::unordered_map<size_t, Value> um;
+        for (int i = 0; i < n; i++) {
+            if (x[i] == 0) {
+                um[y[i]] = Value(i);
+            }
+            if (x[i] == 1) {
+                um.erase(y[i]);
+            }
+            if (x[i] == 2) {
+                Bench::doNotOptimize(um[y[i]].val);
+            }
         }
-    }
-    auto end2 = std::chrono::steady_clock::now();
+    });
 
-    auto start3 = std::chrono::steady_clock::now();
-    for (int i = 0; i < n; i++) {
-        auto find_y = [i](std::pair<size_t, Value> a) {
-            return static_cast<int>(a.first) == y[i];
-        };
-        auto it = std::find_if(lst.begin(), lst.end(), find_y);
-        if (x[i] == 0) {
-            if (it != lst.end()) 
-                it->second.val = i;
-            else lst.emplace_front(y[i], Value(i));
-            // printf("insert %d %d\n", y, i);
-        }
-        if (x[i] == 1) {
-            if (it != lst.end()) lst.erase(it);
-            // printf("erase %d\n", y);
-        }
-        if (x[i] == 2) {
-            if (it == lst.end()) {
-                lst.emplace_front(y[i], Value());
-                it = lst.begin();
+    // a linear scan per operation, a few samples are plenty
+    runner.options.samples = 3;
+    runner.run("list", [&]() {
+        std::list<std::pair<size_t, Value>> lst;
+        for (int i = 0; i < n; i++) {
+            auto find_y = [i](const std::pair<size_t, Value> &a) {
+                return static_cast<int>(a.first) == y[i];
+            };
+            auto it = std::find_if(lst.begin(), lst.end(), find_y);
+            if (x[i] == 0) {
+                if (it != lst.end()) 
+                    it->second.val = i;
+                else lst.emplace_front(y[i], Value(i));
+            }
+            if (x[i] == 1) {
+                if (it != lst.end()) lst.erase(it);
+            }
+            if (x[i] == 2) {
+                if (it == lst.end()) {
+                    lst.emplace_front(y[i], Value());
+                    it = lst.begin();
+                }
+                Bench::doNotOptimize(it->second.val);
             }
-            it->second.val;
-            // printf("%d %d %d\n", ht[y].val, um[y].val, it->second.val);
         }
+    });
+    if (argc > 1 && !runner.writeJson(argv[1])) {
+        std::cerr << "can not write " << argv[1] << "\n";
+        return 1;
     }
-    auto end3 = std::chrono::steady_clock::now();
-    std::chrono::duration<double> elapsed_seconds1 = end1 - start1;
-    std::cout << "elapsed time of HashTable:        " << elapsed_seconds1.count() << "s\n";
-    std::chrono::duration<double> elapsed_seconds2 = end2 - start2;
-    std::cout << "elapsed time of unordered_map:    " << elapsed_seconds2.count() << "s\n";
-    std::chrono::duration<double> elapsed_seconds3 = end3 - start3;
-    std::cout << "elapsed time of list:             " << elapsed_seconds3.count() << "s\n";
     return 0;
 }
\ No newline at end of file
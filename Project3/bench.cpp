@@ -0,0 +1,53 @@
+// Benchmark of the KDTree operations on random 3D integer keys
+//
+// Usage: bench [n] [json file]
+
+#include "kdtree.hpp"
+#include "../common/benchmark.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+typedef KDTree<std::tuple<int, int, int>, int> Tree;
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? static_cast<size_t>(std::atol(argv[1])) : 100000;
+    std::mt19937 rng(281);
+    std::uniform_int_distribution<int> coordinate(0, 1000000);
+    Tree::InitVec points(n), probes(n);
+    for (size_t i = 0; i < n; i++) {
+        points[i] = {{coordinate(rng), coordinate(rng), coordinate(rng)}, static_cast<int>(i)};
+        probes[i] = {{coordinate(rng), coordinate(rng), coordinate(rng)}, static_cast<int>(i)};
+    }
+
+    Bench::Runner runner;
+    runner.context("n", std::to_string(n));
+    Tree tree;
+    runner.run("build", [&]() { tree = Tree(points); });
+    runner.run("find (present)", [&]() {
+        for (auto &p : points) Bench::doNotOptimize(tree.find(p.first));
+    });
+    runner.run("find (absent)", [&]() {
+        for (auto &p : probes) Bench::doNotOptimize(tree.find(p.first));
+    });
+    runner.run("findMin / findMax", [&]() {
+        Bench::doNotOptimize(tree.findMin<0>());
+        Bench::doNotOptimize(tree.findMax<1>());
+        Bench::doNotOptimize(tree.findMin<2>());
+    });
+    Tree grown;
+    runner.run("insert", [&]() { grown = Tree(); }, [&]() {
+        for (auto &p : points) grown.insert(p.first, p.second);
+    });
+    Tree shrunk;
+    runner.run("erase", [&]() { shrunk = tree; }, [&]() {
+        for (auto &p : points) shrunk.erase(p.first);
+    });
+    if (argc > 2 && !runner.writeJson(argv[2])) {
+        std::fprintf(stderr, "can not write %s\n", argv[2]);
+        return 1;
+    }
+    return 0;
+}
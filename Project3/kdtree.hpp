@@ -86,7 +86,7 @@ public:
         void decrement() {
             // TODO: implement this function
             if (node == nullptr) return;
-            if (node->right == nullptr) {
+            if (node->left == nullptr) {
                 Node *last_node = nullptr;
                 while (node != nullptr && node->left == last_node) {
                     last_node = node;
@@ -329,17 +329,20 @@ protected:                      // DO NOT USE private HERE!
             }
             else if (node->right != nullptr) {
                 Node *minNode = findMin<DIM, DIM_NEXT>(node->right);
-                auto &temp = const_cast<Key &>(node->key());
-                temp = minNode->key();
+                Key minKey = minNode->key();
+                const_cast<Key &>(node->key()) = minKey;
                 node->value() = minNode->value();
-                node->right = erase<DIM_NEXT>(node->right, minNode->key());
+                node->right = erase<DIM_NEXT>(node->right, minKey);
             }
             else {
-                Node *maxNode = findMax<DIM, DIM_NEXT>(node->left);
-                auto &temp = const_cast<Key &>(node->key());
-                temp = maxNode->key();
-                node->value() = maxNode->value();
-                node->left = erase<DIM_NEXT>(node->left, maxNode->key());
+                // the maximum of the left subtree may tie with other nodes on DIM, which must stay on the right;
+                // take the minimum instead and move the subtree to the right
+                Node *minNode = findMin<DIM, DIM_NEXT>(node->left);
+                Key minKey = minNode->key();
+                const_cast<Key &>(node->key()) = minKey;
+                node->value() = minNode->value();
+                node->right = erase<DIM_NEXT>(node->left, minKey);
+                node->left = nullptr;
             }
         }
         else {
@@ -373,6 +376,8 @@ protected:                      // DO NOT USE private HERE!
             return std::get<DIM>(a.first) < std::get<DIM>(b.first);
         });
         typename InitVec::iterator mid = l + (r - l) / 2;
+        // keys equal to the median on DIM go right, like in insert and find
+        while (mid != l && std::get<DIM>((mid - 1)->first) == std::get<DIM>(mid->first)) --mid;
         Node *node = new Node(mid->first, mid->second, parent);
         node->left = buildTree<DIM_NEXT>(l, mid, node);
         node->right = buildTree<DIM_NEXT>(mid + 1, r, node);
@@ -0,0 +1,147 @@
+// Tests of the k-d tree against a brute-force map: bulk construction, inserts, erases, lookups and the minimum and
+// maximum along every dimension
+//
+// Usage: kdtree_test
+
+#include "kdtree.hpp"
+#include "../common/check.hpp"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <tuple>
+#include <vector>
+
+typedef std::tuple<int, int, int> Key;
+typedef KDTree<Key, int> Tree;
+typedef std::map<Key, int> Reference;
+
+static std::mt19937_64 rng(281);
+
+// coordinates in [0, range), a small range makes ties on every dimension
+static Key random_key(int range) {
+    std::uniform_int_distribution<int> coordinate(0, range - 1);
+    int x = coordinate(rng), y = coordinate(rng), z = coordinate(rng);
+    return Key(x, y, z);
+}
+
+static int coordinate(const Key &key, size_t dim) {
+    return dim == 0 ? std::get<0>(key) : dim == 1 ? std::get<1>(key) : std::get<2>(key);
+}
+
+static bool same_contents(Tree &tree, const Reference &expected) {
+    if (tree.size() != expected.size()) return false;
+    std::vector<Key> order;
+    for (auto it = tree.begin(); it != tree.end(); ++it) {
+        auto found = expected.find(it->first);
+        if (found == expected.end() || found->second != it->second) return false;
+        order.push_back(it->first);
+    }
+    if (order.size() != expected.size()) return false;
+    // the same order backwards
+    if (!order.empty()) {
+        auto it = tree.find(order.back());
+        for (size_t i = order.size() - 1; i > 0; i--)
+            if ((--it)->first != order[i - 1]) return false;
+    }
+    for (const auto &kv : expected) {
+        auto it = tree.find(kv.first);
+        if (it == tree.end() || it->second != kv.second) return false;
+    }
+    return true;
+}
+
+// findMin and findMax of every dimension, static and dynamic, against a scan of the reference
+static bool extremes_match(Tree &tree, const Reference &expected) {
+    for (size_t dim = 0; dim < 3; dim++) {
+        if (expected.empty()) {
+            if (tree.findMin(dim) != tree.end() || tree.findMax(dim) != tree.end()) return false;
+            continue;
+        }
+        int lo = coordinate(expected.begin()->first, dim), hi = lo;
+        for (const auto &kv : expected) {
+            lo = std::min(lo, coordinate(kv.first, dim));
+            hi = std::max(hi, coordinate(kv.first, dim));
+        }
+        auto min = tree.findMin(dim), max = tree.findMax(dim);
+        if (min == tree.end() || coordinate(min->first, dim) != lo) return false;
+        if (max == tree.end() || coordinate(max->first, dim) != hi) return false;
+    }
+    if (expected.empty()) return true;
+    return tree.findMin<0>() == tree.findMin(0) && tree.findMin<1>() == tree.findMin(1) &&
+           tree.findMin<2>() == tree.findMin(2) && tree.findMax<0>() == tree.findMax(0) &&
+           tree.findMax<1>() == tree.findMax(1) && tree.findMax<2>() == tree.findMax(2);
+}
+
+static void test_construction() {
+    for (size_t n : {0, 1, 2, 1000, 20000}) {
+        Reference expected;
+        while (expected.size() < n) expected[random_key(1000)] = static_cast<int>(rng());
+        std::vector<std::pair<Key, int>> points(expected.begin(), expected.end());
+        std::shuffle(points.begin(), points.end(), rng);
+        Tree tree(points);
+        VE281_CHECK(same_contents(tree, expected));
+        VE281_CHECK(extremes_match(tree, expected));
+        VE281_CHECK(tree.find(Key(-1, -1, -1)) == tree.end());
+    }
+}
+
+static void test_insert_erase() {
+    for (int range : {4, 100}) {
+        Tree tree;
+        Reference expected;
+        std::uniform_int_distribution<int> kind(0, 2);
+        for (size_t i = 0; i < 20000; i++) {
+            Key key = random_key(range);
+            if (kind(rng) == 0) {
+                bool existed = expected.erase(key) > 0;
+                VE281_CHECK(tree.erase(key) == existed);
+            }
+            else {
+                int value = static_cast<int>(rng());
+                tree.insert(key, value);
+                expected[key] = value;
+            }
+            if (i % 1000 == 0) VE281_CHECK(extremes_match(tree, expected));
+        }
+        VE281_CHECK(same_contents(tree, expected));
+        VE281_CHECK(extremes_match(tree, expected));
+        // erase down to empty, checking the extremes on the way
+        std::vector<Key> keys;
+        for (const auto &kv : expected) keys.push_back(kv.first);
+        std::shuffle(keys.begin(), keys.end(), rng);
+        for (size_t i = 0; i < keys.size(); i++) {
+            VE281_CHECK(tree.erase(keys[i]));
+            expected.erase(keys[i]);
+            if (i % 97 == 0) VE281_CHECK(extremes_match(tree, expected));
+        }
+        VE281_CHECK(tree.size() == 0);
+        VE281_CHECK(tree.begin() == tree.end());
+        VE281_CHECK(extremes_match(tree, expected));
+    }
+}
+
+static void test_copies() {
+    Reference expected;
+    while (expected.size() < 3000) expected[random_key(500)] = static_cast<int>(rng());
+    Tree tree(std::vector<std::pair<Key, int>>(expected.begin(), expected.end()));
+    Tree copy(tree), assigned;
+    assigned.insert(Key(0, 0, 0), 0);
+    assigned = tree;
+    Reference before = expected;
+    for (const auto &kv : before)
+        if (rng() % 2) {
+            tree.erase(kv.first);
+            expected.erase(kv.first);
+        }
+    VE281_CHECK(same_contents(tree, expected));
+    VE281_CHECK(same_contents(copy, before));
+    VE281_CHECK(same_contents(assigned, before));
+}
+
+int main() {
+    Check::run("bulk construction", test_construction);
+    Check::run("insert and erase", test_insert_erase);
+    Check::run("copies", test_copies);
+    return Check::report();
+}
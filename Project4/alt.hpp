@@ -0,0 +1,285 @@
+#ifndef VE281P4_ALT_HPP
+#define VE281P4_ALT_HPP
+
+#include <vector>
+#include <queue>
+#include <chrono>
+#include <functional>
+#include "graph.hpp"
+
+/**
+ * Landmark (ALT) distance oracle over a graph with nonnegative weights
+ * For each of L landmarks l it stores d(l, v) and d(v, l) for every v, so the memory is O(Ln)
+ * By the triangle inequality these give instant lower / upper bounds of d(s, t),
+ * and the lower bound is a consistent A* potential for exact queries
+ */
+class LandmarkOracle {
+public:
+    enum class Selection { Farthest, Avoid };
+
+    struct Stats {
+        double seconds = 0;     // preprocessing wall time
+        size_t bytes = 0;       // memory of the distance tables
+        ui landmarks = 0;       // number of landmarks actually selected
+    };
+
+    /**
+     * A* scratch space, queries through distinct workspaces may run concurrently
+     */
+    struct Workspace {
+        std::vector<long long> dist;    // INF_DIST between queries
+        std::vector<ui> pred;           // predecessors of the last query
+
+        void resize(ui n) {
+            dist.assign(n, INF_DIST);
+            pred.assign(n, n);
+        }
+    };
+
+    LandmarkOracle() = default;
+
+    /**
+     * Peak memory of build() with L landmarks on a graph with n vertices and m arcs:
+     * the forward and reverse graphs, 2L distance tables and the selection scratch
+     */
+    static size_t estimateBytes(ui n, size_t m, ui L) {
+        size_t graphs = 2 * ((static_cast<size_t>(n) + 1) * sizeof(ui) + m * (sizeof(ui) + sizeof(long long)));
+        size_t tables = 2 * static_cast<size_t>(std::min(L, n)) * n * sizeof(long long);
+        // reversal sort buffers, dijkstra output, and the tree of the avoid heuristic
+        size_t scratch = 2 * m * sizeof(Edge) + static_cast<size_t>(n) * (4 * sizeof(long long) + 6 * sizeof(ui)
+                                                                       + sizeof(std::vector<ui>) + 1);
+        return graphs + tables + scratch;
+    }
+
+    /**
+     * Select landmarks and compute their distance tables
+     * Time Complexity: O(L m log n)
+     * @param g a graph with nonnegative weights
+     * @param L number of landmarks, clamped to the number of vertices
+     * @param selection
+     */
+    void build(const CSRGraph &g, ui L, Selection selection = Selection::Avoid) {
+        auto start = std::chrono::steady_clock::now();
+        graph = g;
+        reverse = g.reverse();
+        n = g.n;
+        if (L > n) L = n;
+        landmarks.clear();
+        fromTable.clear();
+        toTable.clear();
+        stats = Stats();
+        scratch.resize(n);
+        if (L > 0 && selection == Selection::Farthest) selectFarthest(L);
+        else if (L > 0) selectAvoid(L);
+        stats.landmarks = static_cast<ui>(landmarks.size());
+        stats.bytes = (fromTable.capacity() + toTable.capacity() + n) * sizeof(long long) + n * sizeof(ui)
+                      + graph.memoryUsage() + reverse.memoryUsage();
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /**
+     * Time Complexity: O(L)
+     * @return a lower bound of d(s, t), INF_DIST if t is provably unreachable from s
+     */
+    long long lowerBound(ui s, ui t) const {
+        long long best = 0;
+        for (size_t l = 0; l < landmarks.size(); l++) {
+            const long long *from = &fromTable[l * n];
+            const long long *to = &toTable[l * n];
+            // d(l, t) <= d(l, s) + d(s, t)
+            if (from[s] != INF_DIST) {
+                if (from[t] == INF_DIST) return INF_DIST;
+                best = std::max(best, from[t] - from[s]);
+            }
+            // d(s, l) <= d(s, t) + d(t, l)
+            if (to[t] != INF_DIST) {
+                if (to[s] == INF_DIST) return INF_DIST;
+                best = std::max(best, to[s] - to[t]);
+            }
+        }
+        return best;
+    }
+
+    /**
+     * Time Complexity: O(L)
+     * @return an upper bound of d(s, t) through some landmark, INF_DIST if no landmark connects them
+     */
+    long long upperBound(ui s, ui t) const {
+        long long best = INF_DIST;
+        for (size_t l = 0; l < landmarks.size(); l++) {
+            long long a = toTable[l * n + s], b = fromTable[l * n + t];
+            if (a != INF_DIST && b != INF_DIST) best = std::min(best, a + b);
+        }
+        return s == t ? 0 : best;
+    }
+
+    /**
+     * Exact distance by A* with the landmark lower bound as potential
+     * Time Complexity: O(L m log n) worst case, usually a small fraction of the graph is visited
+     * @return d(s, t), INF_DIST if unreachable
+     */
+    long long query(ui s, ui t) { return query(s, t, scratch); }
+
+    /**
+     * Same as query(s, t), but through a caller-owned workspace, so it can run concurrently
+     */
+    long long query(ui s, ui t, Workspace &ws) const {
+        auto &dist = ws.dist;
+        auto &pred = ws.pred;
+        if (s == t) return 0;
+        if (lowerBound(s, t) == INF_DIST) return INF_DIST;
+        typedef std::pair<long long, ui> Item;
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item>> q;
+        std::vector<ui> touched;
+        dist[s] = 0;
+        touched.push_back(s);
+        q.emplace(lowerBound(s, t), s);
+        long long ans = INF_DIST;
+        while (!q.empty()) {
+            ui u = q.top().second;
+            q.pop();
+            if (u == t) {
+                ans = dist[t];
+                break;
+            }
+            long long d = dist[u];
+            for (ui i = graph.offset[u]; i < graph.offset[u + 1]; i++) {
+                ui v = graph.to[i];
+                long long nd = d + graph.weight[i];
+                if (nd < dist[v]) {
+                    long long pi = lowerBound(v, t);
+                    if (pi == INF_DIST) continue;
+                    if (dist[v] == INF_DIST) touched.push_back(v);
+                    dist[v] = nd;
+                    pred[v] = u;
+                    q.emplace(nd + pi, v);
+                }
+            }
+        }
+        for (ui v : touched) dist[v] = INF_DIST;
+        return ans;
+    }
+
+    /**
+     * Time Complexity: query plus O(path length)
+     * @return the vertices of a shortest path from s to t, empty if t is unreachable
+     */
+    std::vector<ui> path(ui s, ui t) { return path(s, t, scratch); }
+
+    std::vector<ui> path(ui s, ui t, Workspace &ws) const {
+        if (query(s, t, ws) == INF_DIST) return {};
+        std::vector<ui> result{t};
+        while (result.back() != s) result.push_back(ws.pred[result.back()]);
+        std::reverse(result.begin(), result.end());
+        return result;
+    }
+
+    /**
+     * @return a workspace sized for this oracle
+     */
+    Workspace workspace() const {
+        Workspace ws;
+        ws.resize(n);
+        return ws;
+    }
+
+    const std::vector<ui> &getLandmarks() const { return landmarks; }
+
+    const Stats &getStats() const { return stats; }
+
+protected:
+    ui n = 0;
+    CSRGraph graph, reverse;
+    std::vector<ui> landmarks;
+    std::vector<long long> fromTable;   // fromTable[l * n + v] = d(landmarks[l], v)
+    std::vector<long long> toTable;     // toTable[l * n + v] = d(v, landmarks[l])
+    Workspace scratch;                  // used by the single-threaded query / path
+    Stats stats;
+
+    void addLandmark(ui l) {
+        std::vector<long long> d;
+        landmarks.push_back(l);
+        dijkstra(graph, l, d);
+        fromTable.insert(fromTable.end(), d.begin(), d.end());
+        dijkstra(reverse, l, d);
+        toTable.insert(toTable.end(), d.begin(), d.end());
+    }
+
+    /**
+     * @return the vertex farthest from all chosen landmarks (unreachable ones first), or n if every vertex is one
+     */
+    ui farthestVertex() const {
+        long long far = 0;
+        ui next = n;
+        for (ui v = 0; v < n; v++) {
+            long long closest = INF_DIST;
+            for (size_t l = 0; l < landmarks.size(); l++)
+                closest = std::min({closest, fromTable[l * n + v], toTable[l * n + v]});
+            if (closest > far) {
+                far = closest;
+                next = v;
+            }
+        }
+        return next;
+    }
+
+    /**
+     * Repeatedly pick the vertex farthest from all chosen landmarks
+     */
+    void selectFarthest(ui L) {
+        while (landmarks.size() < L) {
+            ui v = farthestVertex();
+            if (v == n) break;
+            addLandmark(v);
+        }
+    }
+
+    /**
+     * The avoid heuristic (Goldberg & Werneck): grow a shortest path tree from a random root, weigh every vertex
+     * by how badly the current landmarks bound its distance from the root, and walk down the heaviest subtree
+     * that contains no landmark to a leaf
+     */
+    void selectAvoid(ui L) {
+        std::vector<long long> d, size(n);
+        std::vector<ui> parent, order;
+        std::vector<char> covered(n);
+        std::vector<std::vector<ui>> children(n);
+        ui seed = 0;
+        addLandmark(farthestVertex());
+        while (landmarks.size() < L) {
+            seed = seed * 1103515245u + 12345u;
+            ui root = seed % n;
+            dijkstra(graph, root, d, &parent);
+            for (ui v = 0; v < n; v++) children[v].clear();
+            for (ui v = 0; v < n; v++) if (parent[v] != n) children[parent[v]].push_back(v);
+            // top-down order of the tree, reversed below so that children come before parents
+            order.assign(1, root);
+            for (size_t i = 0; i < order.size(); i++)
+                for (ui c : children[order[i]]) order.push_back(c);
+            std::reverse(order.begin(), order.end());
+            for (ui v : order) {
+                size[v] = d[v] - lowerBound(root, v);
+                covered[v] = 0;
+            }
+            for (ui l : landmarks) covered[l] = 1;
+            for (ui v : order) {
+                if (v == root) continue;
+                if (covered[v]) covered[parent[v]] = 1;
+                else size[parent[v]] += size[v];
+            }
+            ui u = root;
+            while (true) {
+                ui next = n;
+                for (ui c : children[u])
+                    if (!covered[c] && size[c] > 0 && (next == n || size[c] > size[next])) next = c;
+                if (next == n) break;
+                u = next;
+            }
+            if (covered[u] || size[u] == 0) u = farthestVertex();
+            if (u == n) break;
+            addLandmark(u);
+        }
+    }
+};
+
+#endif //VE281P4_ALT_HPP
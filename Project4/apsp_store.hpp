@@ -0,0 +1,266 @@
+#ifndef VE281P4_APSP_STORE_HPP
+#define VE281P4_APSP_STORE_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <functional>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "graph.hpp"
+
+/**
+ * On-disk all-pairs distance store, written once and memory-mapped by query processes
+ *
+ * File layout (little endian):
+ *   Header                              64 bytes
+ *   TileEntry index[tiles * tiles]      row-major over (tile row, tile column)
+ *   tile data                           each tile starts on an 8-byte boundary
+ *
+ * The matrix is cut into TILE x TILE tiles. In a compressed file every tile is frame-of-reference coded:
+ * a value is stored as (d - base) in `bits` bits, and the code infCode marks an unreachable pair.
+ * Tiles whose range needs more than 56 bits, and every tile of an uncompressed file, store raw 64-bit words.
+ * Looking up d(A, B) reads one index entry and at most 8 bytes inside one tile.
+ */
+class APSPStore {
+public:
+    static constexpr ui TILE = 64;
+    static constexpr uint32_t RAW_BITS = 64;
+
+    APSPStore() = default;
+
+    APSPStore(const APSPStore &) = delete;
+
+    APSPStore &operator=(const APSPStore &) = delete;
+
+    ~APSPStore() { close(); }
+
+    /**
+     * Write an n x n distance matrix to path
+     * Rows are requested one tile row at a time, so only TILE * n distances are held in memory
+     * Time Complexity: O(n^2) plus the cost of dist
+     * @throw std::runtime_error if the file can not be written
+     * @param path
+     * @param n number of vertices
+     * @param dist dist(A, B) returns the distance, INF_DIST if unreachable
+     * @param compress frame-of-reference bit packing of every tile
+     */
+    static void write(const std::string &path, ui n, const std::function<long long(ui, ui)> &dist,
+                      bool compress = true) {
+        FILE *file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr) throw std::runtime_error("cannot open " + path);
+        ui tiles = (n + TILE - 1) / TILE;
+        Header header;
+        std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+        header.version = VERSION;
+        header.n = n;
+        header.tile = TILE;
+        header.compressed = compress;
+        header.indexOffset = sizeof(Header);
+        std::vector<TileEntry> index(static_cast<size_t>(tiles) * tiles);
+        uint64_t offset = header.indexOffset + index.size() * sizeof(TileEntry);
+        // the index is written last, once every tile offset is known
+        bool ok = std::fseek(file, static_cast<long>(offset), SEEK_SET) == 0;
+
+        std::vector<long long> block(static_cast<size_t>(TILE) * n);
+        std::vector<uint64_t> words;
+        for (ui tr = 0; tr < tiles && ok; tr++) {
+            ui rows = std::min(TILE, n - tr * TILE);
+            for (ui r = 0; r < rows; r++)
+                for (ui c = 0; c < n; c++)
+                    block[static_cast<size_t>(r) * n + c] = dist(tr * TILE + r, c);
+            for (ui tc = 0; tc < tiles && ok; tc++) {
+                TileEntry &entry = index[static_cast<size_t>(tr) * tiles + tc];
+                encodeTile(block.data() + tc * TILE, n, rows, std::min(TILE, n - tc * TILE), compress,
+                           entry, words);
+                entry.offset = offset;
+                ok = std::fwrite(words.data(), sizeof(uint64_t), words.size(), file) == words.size();
+                offset += words.size() * sizeof(uint64_t);
+            }
+        }
+        ok = ok && std::fseek(file, 0, SEEK_SET) == 0
+             && std::fwrite(&header, sizeof(Header), 1, file) == 1
+             && std::fwrite(index.data(), sizeof(TileEntry), index.size(), file) == index.size();
+        ok = std::fclose(file) == 0 && ok;
+        if (!ok) throw std::runtime_error("cannot write " + path);
+    }
+
+    /**
+     * Map a file written by write()
+     * @throw std::runtime_error if the file can not be mapped or is not a distance store
+     */
+    void open(const std::string &path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("cannot open " + path);
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+            ::close(fd);
+            throw std::runtime_error("not a distance store: " + path);
+        }
+        length = static_cast<size_t>(st.st_size);
+        void *addr = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED) throw std::runtime_error("cannot mmap " + path);
+        base = static_cast<const unsigned char *>(addr);
+        const Header *header = reinterpret_cast<const Header *>(base);
+        n = header->n;
+        tiles = (n + TILE - 1) / TILE;
+        bool valid = std::memcmp(header->magic, MAGIC, sizeof(header->magic)) == 0 && header->version == VERSION
+                     && header->tile == TILE && header->indexOffset % alignof(TileEntry) == 0
+                     && header->indexOffset <= length
+                     && static_cast<uint64_t>(tiles) * tiles <= (length - header->indexOffset) / sizeof(TileEntry);
+        if (valid) {
+            index = reinterpret_cast<const TileEntry *>(base + header->indexOffset);
+            valid = validTiles();
+        }
+        if (!valid) {
+            close();
+            throw std::runtime_error("not a distance store: " + path);
+        }
+        // queries are random point reads
+        madvise(const_cast<unsigned char *>(base), length, MADV_RANDOM);
+    }
+
+    void close() {
+        if (base != nullptr) munmap(const_cast<unsigned char *>(base), length);
+        base = nullptr;
+        index = nullptr;
+        length = 0;
+        n = tiles = 0;
+    }
+
+    bool isOpen() const { return base != nullptr; }
+
+    ui size() const { return n; }
+
+    /**
+     * Time Complexity: O(1), one index entry and one read inside a tile
+     * @return d(A, B), INF_DIST if unreachable
+     */
+    long long distance(ui A, ui B) const {
+        const TileEntry &entry = index[static_cast<size_t>(A / TILE) * tiles + B / TILE];
+        ui cols = std::min(TILE, n - B / TILE * TILE);
+        uint64_t pos = static_cast<uint64_t>(A % TILE) * cols + B % TILE;
+        const unsigned char *data = base + entry.offset;
+        uint64_t code;
+        if (entry.bits == RAW_BITS) {
+            std::memcpy(&code, data + pos * sizeof(uint64_t), sizeof(uint64_t));
+        }
+        else if (entry.bits == 0) {
+            code = 0;
+        }
+        else {
+            uint64_t bit = pos * entry.bits;
+            std::memcpy(&code, data + bit / 8, sizeof(uint64_t));
+            code = (code >> (bit % 8)) & ((uint64_t(1) << entry.bits) - 1);
+        }
+        if (code == entry.infCode) return INF_DIST;
+        return static_cast<long long>(code + static_cast<uint64_t>(entry.base));
+    }
+
+protected:
+    static constexpr char MAGIC[8] = {'V', 'E', '2', '8', '1', 'A', 'P', 'S'};
+    static constexpr uint32_t VERSION = 1;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t n;
+        uint32_t tile;
+        uint32_t compressed;
+        uint64_t indexOffset;
+        unsigned char reserved[32];
+    };
+    static_assert(sizeof(Header) == 64, "header must be 64 bytes");
+
+    struct TileEntry {
+        uint64_t offset;    // file offset of the tile data
+        int64_t base;       // frame of reference
+        uint64_t infCode;   // code of an unreachable pair
+        uint32_t bits;      // bits per value, RAW_BITS for raw words
+        uint32_t reserved;
+    };
+
+    const unsigned char *base = nullptr;
+    const TileEntry *index = nullptr;
+    size_t length = 0;
+    ui n = 0, tiles = 0;
+
+    /**
+     * Length in words of the data of a rows x cols tile of the given bits per value, as written by encodeTile
+     */
+    static uint64_t tileWords(ui rows, ui cols, uint32_t bits) {
+        uint64_t values = static_cast<uint64_t>(rows) * cols;
+        if (bits == RAW_BITS) return values;
+        return (values * bits + 63) / 64 + 1;
+    }
+
+    /**
+     * Whether every index entry has a valid width and its tile data lies inside the file
+     */
+    bool validTiles() const {
+        for (ui tr = 0; tr < tiles; tr++) {
+            for (ui tc = 0; tc < tiles; tc++) {
+                const TileEntry &entry = index[static_cast<size_t>(tr) * tiles + tc];
+                if (entry.bits > 56 && entry.bits != RAW_BITS) return false;
+                if (entry.offset % sizeof(uint64_t) != 0 || entry.offset > length) return false;
+                uint64_t words = tileWords(std::min(TILE, n - tr * TILE), std::min(TILE, n - tc * TILE), entry.bits);
+                if (words > (length - entry.offset) / sizeof(uint64_t)) return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Encode a rows x cols tile whose first row starts at src with the given row stride
+     * words receives the tile data, padded so that an 8-byte read at any value never leaves the tile
+     */
+    static void encodeTile(const long long *src, size_t stride, ui rows, ui cols, bool compress,
+                           TileEntry &entry, std::vector<uint64_t> &words) {
+        long long lo = INF_DIST, hi = -INF_DIST;
+        for (ui r = 0; r < rows; r++) {
+            for (ui c = 0; c < cols; c++) {
+                long long d = src[r * stride + c];
+                if (d == INF_DIST) continue;
+                lo = std::min(lo, d);
+                hi = std::max(hi, d);
+            }
+        }
+        uint64_t range = lo > hi ? 0 : static_cast<uint64_t>(hi - lo) + 1;   // codes 0 .. range - 1 are finite
+        uint32_t bits = 0;
+        while (bits < 64 && (uint64_t(1) << bits) <= range) bits++;
+        entry.reserved = 0;
+        if (!compress || bits > 56) {
+            entry.bits = RAW_BITS;
+            entry.base = 0;
+            entry.infCode = static_cast<uint64_t>(INF_DIST);
+            words.assign(tileWords(rows, cols, RAW_BITS), 0);
+            for (ui r = 0; r < rows; r++)
+                for (ui c = 0; c < cols; c++)
+                    words[static_cast<size_t>(r) * cols + c] = static_cast<uint64_t>(src[r * stride + c]);
+            return;
+        }
+        entry.bits = bits;
+        entry.base = lo > hi ? 0 : lo;
+        entry.infCode = range;
+        words.assign(tileWords(rows, cols, bits), 0);
+        uint64_t bit = 0;
+        for (ui r = 0; r < rows; r++) {
+            for (ui c = 0; c < cols; c++, bit += bits) {
+                if (bits == 0) continue;
+                long long d = src[r * stride + c];
+                uint64_t code = d == INF_DIST ? range : static_cast<uint64_t>(d - lo);
+                words[bit / 64] |= code << (bit % 64);
+                if (bit % 64 + bits > 64) words[bit / 64 + 1] |= code >> (64 - bit % 64);
+            }
+        }
+    }
+};
+
+#endif //VE281P4_APSP_STORE_HPP
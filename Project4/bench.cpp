@@ -0,0 +1,305 @@
+// Benchmark of the shortest path engines on synthetic graphs
+//
+// Usage: bench [max n] [queries] [seed] [json file]
+//
+// For every generator (G(n, m), 2D grid, R-MAT, and G(n, m) with negative arcs from potentials) and every
+// size n = 1024, 4096, ... up to max n (default 4096), it reports
+//   load:          text and binary edge-list parsing, CSR construction
+//   preprocessing: Johnson potentials, Floyd-Warshall and min-plus squaring (n <= FW_LIMIT), CH and ALT
+//   queries:       single-source Dijkstra (on the reweighted graph, and over potentials),
+//                  the Johnson all-pairs time extrapolated from it, and point-to-point queries of every engine
+// CH and ALT answers are checked against each other and against Dijkstra.
+//
+// A second table compares the label-correcting algorithms that compute Johnson potentials (plain Bellman-Ford,
+// SPFA with FIFO / SLF / SLF + LLL ordering, and the per-component johnsonPotentials) on adversarial inputs:
+// a reverse negative path, a grid and G(n, m) with negative arcs from potentials, and a graph with one
+// negative cycle.
+//
+// A third table renumbers graphs with shuffled vertex ids by every ShortestP2P::Ordering and reports the
+// build and query time of every engine, with the speedup over the input order.
+//
+// Every time in the first table is also kept as a benchmark result (queries as the median of several runs of
+// the whole query set), and written with its samples to the JSON file if one is given.
+
+#include "shortestP2P.hpp"
+#include "generators.hpp"
+#include "spfa.hpp"
+#include "../common/benchmark.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static constexpr ui FW_LIMIT = 4096;
+static constexpr long long MAX_WEIGHT = 1000;
+static constexpr ui DIJKSTRA_SOURCES = 16;
+
+static Bench::Runner results([]() {
+    Bench::Options options;
+    options.samples = 5;
+    options.print = false;
+    return options;
+}());
+
+static double seconds(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/**
+ * Time fn once, in seconds
+ */
+static double timeIt(const std::function<void()> &fn) {
+    auto start = Clock::now();
+    fn();
+    return seconds(start);
+}
+
+static std::string label(const char *graph, ui n, const char *what) {
+    return std::string(graph) + "/" + std::to_string(n) + "/" + what;
+}
+
+/**
+ * Print a measure, and record it as a benchmark result if it is a time
+ */
+static void report(const char *graph, ui n, size_t m, const char *what, double value, const char *unit,
+                   bool record = true) {
+    std::printf("%-8s %8u %9zu  %-26s %12.3f %s\n", graph, n, m, what, value, unit);
+    std::fflush(stdout);
+    if (!record) return;
+    std::string u = unit;
+    double scale = u.compare(0, 2, "ms") == 0 ? 1e-3 : u.compare(0, 2, "us") == 0 ? 1e-6 : u == "s" ? 1 : 0;
+    if (scale > 0) results.record(label(graph, n, what), {value * scale});
+}
+
+static void benchGraph(const char *name, ui n, const std::vector<Edge> &edges, size_t queries, uint64_t seed) {
+    size_t m = edges.size();
+    std::string text = "/tmp/ve281_bench_" + std::to_string(seed) + ".txt";
+    std::string binary = "/tmp/ve281_bench_" + std::to_string(seed) + ".bin";
+    GraphLoader::saveText(text, n, edges);
+    GraphLoader::saveBinary(binary, n, edges);
+
+    // load
+    ui loadedN;
+    std::vector<Edge> loaded;
+    report(name, n, m, "load text", timeIt([&]() { GraphLoader::load(text, loadedN, loaded); }) * 1e3, "ms");
+    double binaryLoad = timeIt([&]() { GraphLoader::load(binary, loadedN, loaded); });
+    report(name, n, m, "load binary", binaryLoad * 1e3, "ms");
+    CSRGraph g;
+    report(name, n, m, "CSR construction", timeIt([&]() { g = CSRGraph(loadedN, loaded); }) * 1e3, "ms");
+
+    // preprocessing
+    std::vector<long long> h;
+    bool ok = true;
+    report(name, n, m, "Johnson potentials", timeIt([&]() { ok = johnsonPotentials(g, h); }) * 1e3, "ms");
+    if (!ok) {
+        std::printf("%-8s %8u %9zu  negative cycle, skipped\n", name, n, m);
+        return;
+    }
+    CSRGraph r;
+    report(name, n, m, "reweight", timeIt([&]() { r = reweight(g, h); }) * 1e3, "ms");
+
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<ui> vertex(0, n - 1);
+    std::vector<std::pair<ui, ui>> pairs(queries);
+    for (auto &p : pairs) p = {vertex(rng), vertex(rng)};
+    std::vector<long long> expected(queries, INF_DIST);
+
+    // single-source Dijkstra from the first query sources, which also gives reference answers
+    std::vector<long long> dist;
+    ui sources = std::min<ui>(DIJKSTRA_SOURCES, static_cast<ui>(queries));
+    double plain = timeIt([&]() {
+        for (ui i = 0; i < sources; i++) dijkstra(r, pairs[i].first, dist);
+    }) / std::max(1u, sources);
+    double potential = timeIt([&]() {
+        for (ui i = 0; i < sources; i++) {
+            dijkstra(g, h, pairs[i].first, dist);
+            expected[i] = dist[pairs[i].second] == INF_DIST ? INF : dist[pairs[i].second];
+        }
+    }) / std::max(1u, sources);
+    report(name, n, m, "dijkstra (reweighted)", plain * 1e3, "ms/source");
+    report(name, n, m, "dijkstra (potentials)", potential * 1e3, "ms/source");
+    report(name, n, m, "Johnson APSP (estimate)", plain * n, "s", false);
+
+    auto runQueries = [&](const char *what, const std::function<long long(ui, ui)> &query) {
+        size_t mismatches = 0;
+        for (size_t i = 0; i < sources; i++) mismatches += query(pairs[i].first, pairs[i].second) != expected[i];
+        double t = results.run(label(name, n, what), [&]() {
+            for (auto &p : pairs) Bench::doNotOptimize(query(p.first, p.second));
+        }).summary.median;
+        report(name, n, m, what, queries ? t / queries * 1e6 : 0, "us/query", false);
+        if (mismatches) std::printf("%-8s %8u %9zu  %s: %zu WRONG ANSWERS\n", name, n, m, what, mismatches);
+    };
+
+    double t;
+    if (n <= FW_LIMIT) {
+        ShortestP2P fw(ShortestP2P::Engine::FloydWarshall);
+        t = timeIt([&]() { fw.readGraph(binary); });
+        report(name, n, m, "Floyd-Warshall build", std::max(0.0, t - binaryLoad), "s");
+        runQueries("Floyd-Warshall query", [&](ui A, ui B) { return fw.query(A, B); });
+
+        ShortestP2P minPlus(ShortestP2P::Engine::MinPlus);
+        t = timeIt([&]() { minPlus.readGraph(binary); });
+        report(name, n, m, "min-plus squaring build", std::max(0.0, t - binaryLoad), "s");
+        runQueries("min-plus query", [&](ui A, ui B) { return minPlus.query(A, B); });
+    }
+
+    ShortestP2P ch(ShortestP2P::Engine::ContractionHierarchy);
+    t = timeIt([&]() { ch.readGraph(binary); });
+    report(name, n, m, "CH build", std::max(0.0, t - binaryLoad), "s");
+    report(name, n, m, "CH shortcuts", static_cast<double>(ch.chStats().shortcuts), "arcs");
+    runQueries("CH query", [&](ui A, ui B) { return ch.query(A, B); });
+
+    ShortestP2P alt(ShortestP2P::Engine::Landmark);
+    t = timeIt([&]() { alt.readGraph(binary); });
+    report(name, n, m, "ALT build", std::max(0.0, t - binaryLoad), "s");
+    runQueries("ALT query", [&](ui A, ui B) { return alt.query(A, B); });
+
+    size_t disagree = 0;
+    for (auto &p : pairs) disagree += ch.query(p.first, p.second) != alt.query(p.first, p.second);
+    if (disagree) std::printf("%-8s %8u %9zu  CH and ALT disagree on %zu queries\n", name, n, m, disagree);
+
+    std::remove(text.c_str());
+    std::remove(binary.c_str());
+}
+
+static void benchPotentials(const char *name, ui n, const std::vector<Edge> &edges) {
+    CSRGraph g(n, edges);
+    std::vector<long long> reference;
+    bool expected = johnsonPotentials(g, reference);
+    auto run = [&](const char *what, const std::function<bool(std::vector<long long> &, LabelCorrecting::Stats &)> &fn) {
+        std::vector<long long> h(n, 0);
+        LabelCorrecting::Stats stats;
+        bool ok = true;
+        double t = timeIt([&]() { ok = fn(h, stats); });
+        std::printf("%-10s %8u %9zu  %-20s %10.3f ms %12zu %12zu%s\n", name, n, g.edgeCount(), what, t * 1e3,
+                    stats.scans, stats.relaxations,
+                    ok != expected ? "  WRONG CYCLE VERDICT" : ok && h != reference ? "  WRONG POTENTIALS" : "");
+        std::fflush(stdout);
+    };
+    run("bellman-ford", [&](std::vector<long long> &h, LabelCorrecting::Stats &stats) {
+        return LabelCorrecting::bellmanFord(g, h, &stats);
+    });
+    run("spfa fifo", [&](std::vector<long long> &h, LabelCorrecting::Stats &stats) {
+        return LabelCorrecting::spfa(g, h, {false, false}, &stats);
+    });
+    run("spfa slf", [&](std::vector<long long> &h, LabelCorrecting::Stats &stats) {
+        return LabelCorrecting::spfa(g, h, {true, false}, &stats);
+    });
+    run("spfa slf+lll", [&](std::vector<long long> &h, LabelCorrecting::Stats &stats) {
+        return LabelCorrecting::spfa(g, h, {true, true}, &stats);
+    });
+    run("per-component", [&](std::vector<long long> &h, LabelCorrecting::Stats &stats) {
+        return johnsonPotentials(g, h, &stats);
+    });
+}
+
+static void benchOrdering(const char *name, ui n, const std::vector<Edge> &edges, size_t queries, uint64_t seed) {
+    typedef ShortestP2P::Ordering Ordering;
+    typedef ShortestP2P::Engine Engine;
+    const std::pair<Ordering, const char *> orderings[] = {
+            {Ordering::Input, "input"}, {Ordering::BFS, "bfs"}, {Ordering::RCM, "rcm"}, {Ordering::Degree, "degree"}};
+    const std::pair<Engine, const char *> engines[] = {
+            {Engine::FloydWarshall, "fw"}, {Engine::ContractionHierarchy, "ch"}, {Engine::Landmark, "alt"}};
+    std::string binary = "/tmp/ve281_bench_" + std::to_string(seed) + ".bin";
+    GraphLoader::saveBinary(binary, n, edges);
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<ui> vertex(0, n - 1);
+    std::vector<std::pair<ui, ui>> pairs(queries);
+    for (auto &p : pairs) p = {vertex(rng), vertex(rng)};
+
+    for (auto &engine : engines) {
+        if (engine.first == Engine::FloydWarshall && n > FW_LIMIT) continue;
+        double baseBuild = 0, baseQuery = 0;
+        for (auto &order : orderings) {
+            ShortestP2P sp(engine.first);
+            sp.setOrdering(order.first);
+            double build = timeIt([&]() { sp.readGraph(binary); });
+            long long sum = 0;
+            double query = timeIt([&]() {
+                for (auto &p : pairs) sum += sp.query(p.first, p.second);
+            }) / std::max<size_t>(1, queries);
+            if (order.first == Ordering::Input) {
+                baseBuild = build;
+                baseQuery = query;
+            }
+            std::printf("%-8s %8u %9zu  %-4s %-7s %10.3f s %6.2fx %10.3f us %6.2fx  (checksum %lld)\n", name, n,
+                        edges.size(), engine.second, order.second, build, baseBuild / build, query * 1e6,
+                        baseQuery / query, sum);
+            std::fflush(stdout);
+        }
+    }
+    std::remove(binary.c_str());
+}
+
+int main(int argc, char *argv[]) {
+    ui maxN = argc > 1 ? static_cast<ui>(std::atol(argv[1])) : 4096;
+    size_t queries = argc > 2 ? static_cast<size_t>(std::atol(argv[2])) : 1000;
+    uint64_t seed = argc > 3 ? static_cast<uint64_t>(std::atoll(argv[3])) : 281;
+    results.context("max_n", std::to_string(maxN));
+    results.context("queries", std::to_string(queries));
+    results.context("seed", std::to_string(seed));
+
+    std::printf("%-8s %8s %9s  %-26s %12s\n", "graph", "n", "m", "measure", "value");
+    for (ui n = 1024; n <= maxN; n *= 4) {
+        size_t m = 4 * static_cast<size_t>(n);
+        benchGraph("gnm", n, GraphGen::random(n, m, MAX_WEIGHT, seed), queries, seed);
+
+        ui side = 1;
+        while ((side + 1) * (side + 1) <= n) side++;
+        benchGraph("grid", side * side, GraphGen::grid(side, side, MAX_WEIGHT, seed), queries, seed);
+
+        unsigned scale = 0;
+        while ((2u << scale) <= n) scale++;
+        benchGraph("rmat", 1u << scale, GraphGen::rmat(scale, m, MAX_WEIGHT, seed), queries, seed);
+
+        std::vector<Edge> negative = GraphGen::random(n, m, MAX_WEIGHT, seed);
+        GraphGen::addPotentials(n, negative, MAX_WEIGHT, seed + 1);
+        benchGraph("negative", n, negative, queries, seed);
+    }
+
+    std::printf("\n%-10s %8s %9s  %-20s %13s %12s %12s\n", "graph", "n", "m", "algorithm", "time", "scans",
+                "relaxations");
+    for (ui n = 1024; n <= maxN; n *= 4) {
+        size_t m = 4 * static_cast<size_t>(n);
+        benchPotentials("reverse", n, GraphGen::reversePath(n, m, MAX_WEIGHT, seed));
+
+        ui side = 1;
+        while ((side + 1) * (side + 1) <= n) side++;
+        std::vector<Edge> grid = GraphGen::grid(side, side, MAX_WEIGHT, seed);
+        GraphGen::addPotentials(side * side, grid, 100 * MAX_WEIGHT, seed + 1);
+        benchPotentials("grid", side * side, grid);
+
+        std::vector<Edge> negative = GraphGen::random(n, m, MAX_WEIGHT, seed);
+        GraphGen::addPotentials(n, negative, 100 * MAX_WEIGHT, seed + 1);
+        benchPotentials("negative", n, negative);
+
+        // close one long negative cycle through a path of the graph above
+        std::vector<Edge> cycle = negative;
+        for (ui v = 0; v + 1 < n; v += n / 16) cycle.push_back({v, v + n / 16 < n ? v + n / 16 : 0, -MAX_WEIGHT});
+        benchPotentials("neg-cycle", n, cycle);
+    }
+
+    std::printf("\n%-8s %8s %9s  %-4s %-7s %12s %7s %13s %7s\n", "graph", "n", "m", "eng", "order", "build",
+                "speedup", "query", "speedup");
+    ui side = 1;
+    while ((side + 1) * (side + 1) <= maxN) side++;
+    std::vector<Edge> grid = GraphGen::grid(side, side, MAX_WEIGHT, seed);
+    GraphGen::shuffleIds(side * side, grid, seed);
+    benchOrdering("grid", side * side, grid, queries, seed);
+    unsigned scale = 0;
+    while ((2u << scale) <= maxN) scale++;
+    std::vector<Edge> rmat = GraphGen::rmat(scale, 4 * (size_t(1) << scale), MAX_WEIGHT, seed);
+    GraphGen::shuffleIds(1u << scale, rmat, seed);
+    benchOrdering("rmat", 1u << scale, rmat, queries, seed);
+    if (argc > 4 && !results.writeJson(argv[4])) {
+        std::fprintf(stderr, "can not write %s\n", argv[4]);
+        return 1;
+    }
+    return 0;
+}
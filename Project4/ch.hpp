@@ -0,0 +1,365 @@
+#ifndef VE281P4_CH_HPP
+#define VE281P4_CH_HPP
+
+#include <vector>
+#include <queue>
+#include <chrono>
+#include <functional>
+#include <unordered_map>
+#include "graph.hpp"
+
+/**
+ * Contraction Hierarchies over a graph with nonnegative weights
+ * Vertices are contracted in order of edge difference, shortcuts are added when a bounded witness search
+ * can not prove that a path around the contracted vertex is as short
+ * Queries run a bidirectional Dijkstra restricted to upward arcs, paths are recovered by unpacking shortcuts
+ */
+class ContractionHierarchy {
+public:
+    struct Stats {
+        double seconds = 0;     // preprocessing wall time
+        size_t bytes = 0;       // memory of the upward / downward graphs
+        size_t shortcuts = 0;   // number of shortcuts added
+    };
+
+    /**
+     * Query scratch space, queries through distinct workspaces may run concurrently
+     */
+    struct Workspace {
+        std::vector<long long> forwardDist, backwardDist;   // INF_DIST between queries
+        std::vector<ui> forwardPred, backwardPred;
+
+        void resize(ui n) {
+            forwardDist.assign(n, INF_DIST);
+            backwardDist.assign(n, INF_DIST);
+            forwardPred.assign(n, n);
+            backwardPred.assign(n, n);
+        }
+    };
+
+    ContractionHierarchy() = default;
+
+    /**
+     * Expected peak memory of build() on a graph with n vertices and m arcs
+     * The number of shortcuts is not known up front, SHORTCUTS_PER_ARC is a pessimistic typical ratio
+     * (about 0.1 on scale-free graphs, 1.5 on grids, 3.5 on random graphs of average degree 4)
+     */
+    static size_t estimateBytes(ui n, size_t m) {
+        size_t arcs = m + static_cast<size_t>(SHORTCUTS_PER_ARC * static_cast<double>(m));
+        // during contraction: every arc in out and in, plus the emitted up / down edges and a CSR sort buffer
+        size_t contraction = 2 * arcs * sizeof(Arc) + 2 * static_cast<size_t>(n) * sizeof(std::vector<Arc>)
+                             + 2 * arcs * sizeof(Edge);
+        // afterwards: upward / downward CSR graphs, the shortcut middle map and the query workspace
+        size_t result = 2 * (static_cast<size_t>(n) + 1) * sizeof(ui) + arcs * (sizeof(ui) + sizeof(long long))
+                        + (arcs - m) * (sizeof(unsigned long long) + sizeof(ui) + 2 * sizeof(void *))
+                        + static_cast<size_t>(n) * (3 * sizeof(ui) + 3 * sizeof(long long) + 2);
+        return contraction + result;
+    }
+
+    /**
+     * Contract every vertex of g and build the upward / downward search graphs
+     * Time Complexity: depends on the graph, roughly O(n (d log d + witness))
+     * @param g a graph with nonnegative weights
+     */
+    void build(const CSRGraph &g) {
+        auto start = std::chrono::steady_clock::now();
+        n = g.n;
+        stats = Stats();
+        out.assign(n, {});
+        in.assign(n, {});
+        middle.clear();
+        for (ui u = 0; u < n; u++)
+            for (ui i = g.offset[u]; i < g.offset[u + 1]; i++)
+                if (g.to[i] != u) addArc(u, g.to[i], g.weight[i], n);
+        contracted.assign(n, 0);
+        deletedNeighbors.assign(n, 0);
+        witnessDist.assign(n, INF_DIST);
+        rank.assign(n, 0);
+
+        typedef std::pair<long long, ui> Item;
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item>> pq;
+        for (ui v = 0; v < n; v++) pq.emplace(priority(v), v);
+        ui order = 0;
+        std::vector<Edge> up, down;
+        while (!pq.empty()) {
+            ui v = pq.top().second;
+            pq.pop();
+            if (contracted[v]) continue;
+            // lazy update: re-evaluate and postpone if v is no longer the best candidate
+            long long p = priority(v);
+            if (!pq.empty() && p > pq.top().first) {
+                pq.emplace(p, v);
+                continue;
+            }
+            contract(v, up, down);
+            rank[v] = order++;
+        }
+
+        upward = CSRGraph(n, std::move(up));
+        downward = CSRGraph(n, std::move(down));
+        out.clear(), out.shrink_to_fit();
+        in.clear(), in.shrink_to_fit();
+        contracted.clear(), contracted.shrink_to_fit();
+        deletedNeighbors.clear(), deletedNeighbors.shrink_to_fit();
+        witnessDist.clear(), witnessDist.shrink_to_fit();
+
+        scratch.resize(n);
+        stats.bytes = upward.memoryUsage() + downward.memoryUsage() + rank.capacity() * sizeof(ui)
+                      + 2 * n * (sizeof(long long) + sizeof(ui))
+                      + middle.size() * (sizeof(unsigned long long) + sizeof(ui) + 2 * sizeof(void *));
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /**
+     * Time Complexity: O(s log s), s is the size of the upward search spaces of A and B
+     * @param A
+     * @param B
+     * @return the distance from A to B, or INF_DIST if B is unreachable
+     */
+    long long query(ui A, ui B) { return query(A, B, scratch); }
+
+    /**
+     * Same as query(A, B), but through a caller-owned workspace, so it can run concurrently
+     */
+    long long query(ui A, ui B, Workspace &ws) const {
+        ui meet;
+        return search(A, B, meet, ws);
+    }
+
+    /**
+     * Time Complexity: query plus O(path length) to unpack shortcuts
+     * @param A
+     * @param B
+     * @return the vertices of a shortest path from A to B, empty if B is unreachable
+     */
+    std::vector<ui> path(ui A, ui B) { return path(A, B, scratch); }
+
+    std::vector<ui> path(ui A, ui B, Workspace &ws) const {
+        ui meet;
+        if (search(A, B, meet, ws) == INF_DIST) return {};
+        std::vector<ui> up{meet}, result{A};
+        while (up.back() != A) up.push_back(ws.forwardPred[up.back()]);
+        for (size_t i = up.size() - 1; i > 0; i--) unpack(up[i], up[i - 1], result);
+        for (ui u = meet; u != B; u = ws.backwardPred[u]) unpack(u, ws.backwardPred[u], result);
+        return result;
+    }
+
+    /**
+     * @return a workspace sized for this hierarchy
+     */
+    Workspace workspace() const {
+        Workspace ws;
+        ws.resize(n);
+        return ws;
+    }
+
+    const Stats &getStats() const { return stats; }
+
+protected:
+    struct Arc {
+        ui v;
+        long long w;
+        ui mid;     // contracted vertex the arc bypasses, n for an original arc
+    };
+
+    static constexpr size_t WITNESS_SETTLE_LIMIT = 500;
+    static constexpr size_t SIMULATE_SETTLE_LIMIT = 50;
+    static constexpr double SHORTCUTS_PER_ARC = 3.5;
+
+    ui n = 0;
+    std::vector<std::vector<Arc>> out, in;  // dynamic graph during contraction
+    std::vector<char> contracted;
+    std::vector<ui> deletedNeighbors;
+    std::vector<long long> witnessDist;
+    std::vector<ui> rank;
+    CSRGraph upward, downward;              // downward stores the downward arcs reversed
+    Workspace scratch;                      // used by the single-threaded query / path
+    std::unordered_map<unsigned long long, ui> middle;  // (u << 32 | v) -> mid of shortcut u -> v
+    Stats stats;
+
+    static unsigned long long key(ui u, ui v) { return static_cast<unsigned long long>(u) << 32 | v; }
+
+    /**
+     * Bidirectional upward search, meet receives the vertex where the shortest path peaks
+     */
+    long long search(ui A, ui B, ui &meet, Workspace &ws) const {
+        meet = A;
+        if (A == B) return 0;
+        typedef std::pair<long long, ui> Item;
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item>> fq, bq;
+        std::vector<ui> touched;
+        ws.forwardDist[A] = 0, ws.backwardDist[B] = 0;
+        touched.push_back(A), touched.push_back(B);
+        fq.emplace(0, A), bq.emplace(0, B);
+        long long best = INF_DIST;
+        bool forward = true;
+        while (!fq.empty() || !bq.empty()) {
+            if (fq.empty()) forward = false;
+            else if (bq.empty()) forward = true;
+            auto &q = forward ? fq : bq;
+            auto &dist = forward ? ws.forwardDist : ws.backwardDist;
+            auto &other = forward ? ws.backwardDist : ws.forwardDist;
+            auto &pred = forward ? ws.forwardPred : ws.backwardPred;
+            const CSRGraph &g = forward ? upward : downward;
+            forward = !forward;
+            long long d = q.top().first;
+            ui u = q.top().second;
+            q.pop();
+            if (d >= best) {
+                // nothing better can be found from this side any more
+                std::priority_queue<Item, std::vector<Item>, std::greater<Item>>().swap(q);
+                continue;
+            }
+            if (d > dist[u]) continue;
+            if (other[u] != INF_DIST && d + other[u] < best) {
+                best = d + other[u];
+                meet = u;
+            }
+            for (ui i = g.offset[u]; i < g.offset[u + 1]; i++) {
+                ui v = g.to[i];
+                long long nd = d + g.weight[i];
+                if (nd < dist[v]) {
+                    if (dist[v] == INF_DIST && other[v] == INF_DIST) touched.push_back(v);
+                    dist[v] = nd;
+                    pred[v] = u;
+                    q.emplace(nd, v);
+                }
+            }
+        }
+        for (ui v : touched) ws.forwardDist[v] = ws.backwardDist[v] = INF_DIST;
+        return best;
+    }
+
+    /**
+     * Append the original vertices of arc u -> v, excluding u, to result
+     */
+    void unpack(ui u, ui v, std::vector<ui> &result) const {
+        std::vector<std::pair<ui, ui>> stack{{u, v}};
+        while (!stack.empty()) {
+            auto [a, b] = stack.back();
+            stack.pop_back();
+            auto it = middle.find(key(a, b));
+            if (it == middle.end()) {
+                result.push_back(b);
+                continue;
+            }
+            stack.emplace_back(it->second, b);
+            stack.emplace_back(a, it->second);
+        }
+    }
+
+    /**
+     * Add arc u -> v, or lower its weight if it already exists
+     */
+    void addArc(ui u, ui v, long long w, ui mid) {
+        for (auto &a : out[u]) {
+            if (a.v == v) {
+                if (w < a.w) {
+                    a.w = w, a.mid = mid;
+                    for (auto &b : in[v]) if (b.v == u) b.w = w, b.mid = mid;
+                }
+                return;
+            }
+        }
+        out[u].push_back({v, w, mid});
+        in[v].push_back({u, w, mid});
+    }
+
+    /**
+     * Dijkstra from s over uncontracted vertices avoiding skip, bounded by maxDist and a settle limit
+     * Distances are left in witnessDist, touched vertices are appended to touched
+     */
+    void witnessSearch(ui s, ui skip, long long maxDist, size_t limit, std::vector<ui> &touched) {
+        typedef std::pair<long long, ui> Item;
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item>> q;
+        witnessDist[s] = 0;
+        touched.push_back(s);
+        q.emplace(0, s);
+        size_t settled = 0;
+        while (!q.empty()) {
+            long long d = q.top().first;
+            ui u = q.top().second;
+            q.pop();
+            if (d > witnessDist[u]) continue;
+            if (d > maxDist || ++settled > limit) break;
+            for (auto &a : out[u]) {
+                if (a.v == skip) continue;
+                long long nd = d + a.w;
+                if (nd < witnessDist[a.v]) {
+                    if (witnessDist[a.v] == INF_DIST) touched.push_back(a.v);
+                    witnessDist[a.v] = nd;
+                    q.emplace(nd, a.v);
+                }
+            }
+        }
+    }
+
+    /**
+     * Find (or add, if apply is set) the shortcuts needed to contract v
+     * @return the number of shortcuts
+     */
+    size_t shortcuts(ui v, bool apply) {
+        size_t count = 0;
+        std::vector<ui> touched;
+        std::vector<Edge> added;
+        for (auto &a : in[v]) {
+            ui u = a.v;
+            long long maxDist = -1;
+            for (auto &b : out[v])
+                if (b.v != u) maxDist = std::max(maxDist, a.w + b.w);
+            if (maxDist < 0) continue;
+            witnessSearch(u, v, maxDist, apply ? WITNESS_SETTLE_LIMIT : SIMULATE_SETTLE_LIMIT, touched);
+            for (auto &b : out[v]) {
+                if (b.v == u) continue;
+                if (witnessDist[b.v] > a.w + b.w) {
+                    ++count;
+                    if (apply) added.push_back({u, b.v, a.w + b.w});
+                }
+            }
+            for (ui t : touched) witnessDist[t] = INF_DIST;
+            touched.clear();
+        }
+        for (auto &e : added) addArc(e.u, e.v, e.w, v);
+        return count;
+    }
+
+    long long priority(ui v) {
+        long long degree = static_cast<long long>(in[v].size() + out[v].size());
+        return static_cast<long long>(shortcuts(v, false)) - degree + deletedNeighbors[v];
+    }
+
+    /**
+     * Contract v: add its shortcuts, emit its remaining arcs (which all lead to higher ranks) into up / down,
+     * and detach it from the dynamic graph
+     */
+    void contract(ui v, std::vector<Edge> &up, std::vector<Edge> &down) {
+        stats.shortcuts += shortcuts(v, true);
+        contracted[v] = 1;
+        for (auto &a : out[v]) {
+            up.push_back({v, a.v, a.w});
+            if (a.mid != n) middle[key(v, a.v)] = a.mid;
+            ++deletedNeighbors[a.v];
+            detach(in[a.v], v);
+        }
+        for (auto &a : in[v]) {
+            down.push_back({v, a.v, a.w});
+            if (a.mid != n) middle[key(a.v, v)] = a.mid;
+            ++deletedNeighbors[a.v];
+            detach(out[a.v], v);
+        }
+        std::vector<Arc>().swap(out[v]);
+        std::vector<Arc>().swap(in[v]);
+    }
+
+    static void detach(std::vector<Arc> &arcs, ui v) {
+        for (size_t i = 0; i < arcs.size(); i++) {
+            if (arcs[i].v == v) {
+                arcs[i] = arcs.back();
+                arcs.pop_back();
+                return;
+            }
+        }
+    }
+};
+
+#endif //VE281P4_CH_HPP
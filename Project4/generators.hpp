@@ -0,0 +1,137 @@
+#ifndef VE281P4_GENERATORS_HPP
+#define VE281P4_GENERATORS_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "graph.hpp"
+
+/**
+ * Synthetic graph generators for benchmarks, all deterministic in their seed
+ * Weights are drawn uniformly from [0, maxW] and stay within int32 so that every graph fits the binary format
+ */
+namespace GraphGen {
+    /**
+     * Erdos-Renyi style G(n, m): m arcs with independent uniform endpoints
+     * Time Complexity: O(m)
+     */
+    inline std::vector<Edge> random(ui n, size_t m, long long maxW, uint64_t seed) {
+        std::mt19937_64 rng(seed);
+        std::uniform_int_distribution<ui> vertex(0, n - 1);
+        std::uniform_int_distribution<long long> weight(0, maxW);
+        std::vector<Edge> edges(m);
+        for (auto &e : edges) {
+            e.u = vertex(rng);
+            e.v = vertex(rng);
+            e.w = weight(rng);
+        }
+        return edges;
+    }
+
+    /**
+     * rows x cols 2D grid, vertex r * cols + c, with arcs in both directions between 4-neighbours
+     * Time Complexity: O(rows * cols)
+     */
+    inline std::vector<Edge> grid(ui rows, ui cols, long long maxW, uint64_t seed) {
+        std::mt19937_64 rng(seed);
+        std::uniform_int_distribution<long long> weight(0, maxW);
+        std::vector<Edge> edges;
+        edges.reserve(4 * static_cast<size_t>(rows) * cols);
+        for (ui r = 0; r < rows; r++) {
+            for (ui c = 0; c < cols; c++) {
+                ui v = r * cols + c;
+                if (c + 1 < cols) {
+                    edges.push_back({v, v + 1, weight(rng)});
+                    edges.push_back({v + 1, v, weight(rng)});
+                }
+                if (r + 1 < rows) {
+                    edges.push_back({v, v + cols, weight(rng)});
+                    edges.push_back({v + cols, v, weight(rng)});
+                }
+            }
+        }
+        return edges;
+    }
+
+    /**
+     * R-MAT (recursive Kronecker) scale-free graph over 2^scale vertices
+     * Every arc descends scale levels of the adjacency matrix, choosing a quadrant with probabilities
+     * a, b, c and 1 - a - b - c; the defaults are the Graph500 parameters
+     * Time Complexity: O(m scale)
+     */
+    inline std::vector<Edge> rmat(unsigned scale, size_t m, long long maxW, uint64_t seed,
+                                  double a = 0.57, double b = 0.19, double c = 0.19) {
+        std::mt19937_64 rng(seed);
+        std::uniform_real_distribution<double> coin(0, 1);
+        std::uniform_int_distribution<long long> weight(0, maxW);
+        std::vector<Edge> edges(m);
+        for (auto &e : edges) {
+            ui u = 0, v = 0;
+            for (unsigned level = 0; level < scale; level++) {
+                double p = coin(rng);
+                u <<= 1;
+                v <<= 1;
+                if (p < a) continue;
+                if (p < a + b) v |= 1;
+                else if (p < a + b + c) u |= 1;
+                else {
+                    u |= 1;
+                    v |= 1;
+                }
+            }
+            e.u = u;
+            e.v = v;
+            e.w = weight(rng);
+        }
+        return edges;
+    }
+
+    /**
+     * Bellman-Ford adversary: a path n - 1 -> n - 2 -> ... -> 0 of negative arcs plus `extra` random arcs
+     * towards lower ids, so the graph is acyclic; every round in vertex order moves the labels by one arc
+     * Time Complexity: O(n + extra)
+     */
+    inline std::vector<Edge> reversePath(ui n, size_t extra, long long maxW, uint64_t seed) {
+        std::vector<Edge> edges = random(n, extra, maxW, seed);
+        for (auto &e : edges)
+            if (e.u < e.v) std::swap(e.u, e.v);
+        edges.erase(std::remove_if(edges.begin(), edges.end(), [](const Edge &e) { return e.u == e.v; }),
+                    edges.end());
+        std::mt19937_64 rng(seed + 1);
+        std::uniform_int_distribution<long long> weight(1, maxW);
+        for (ui v = n; v-- > 1; ) edges.push_back({v, v - 1, -weight(rng)});
+        return edges;
+    }
+
+    /**
+     * Rename the vertices by a random permutation, as ids of an unordered input file would be
+     * Time Complexity: O(n + m)
+     */
+    inline void shuffleIds(ui n, std::vector<Edge> &edges, uint64_t seed) {
+        std::mt19937_64 rng(seed);
+        std::vector<ui> id(n);
+        for (ui v = 0; v < n; v++) id[v] = v;
+        std::shuffle(id.begin(), id.end(), rng);
+        for (auto &e : edges) {
+            e.u = id[e.u];
+            e.v = id[e.v];
+        }
+    }
+
+    /**
+     * Turn nonnegative weights into w(u, v) + p(v) - p(u) for random potentials p in [0, maxPotential]
+     * Every cycle keeps its nonnegative length, so the result has negative arcs but no negative cycle,
+     * and shortest paths are unchanged up to the potentials
+     * Time Complexity: O(n + m)
+     */
+    inline void addPotentials(ui n, std::vector<Edge> &edges, long long maxPotential, uint64_t seed) {
+        std::mt19937_64 rng(seed);
+        std::uniform_int_distribution<long long> potential(0, maxPotential);
+        std::vector<long long> p(n);
+        for (auto &x : p) x = potential(rng);
+        for (auto &e : edges) e.w += p[e.v] - p[e.u];
+    }
+}
+
+#endif //VE281P4_GENERATORS_HPP
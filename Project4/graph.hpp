@@ -0,0 +1,390 @@
+#ifndef VE281P4_GRAPH_HPP
+#define VE281P4_GRAPH_HPP
+
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include <queue>
+#include <functional>
+
+#ifndef INF
+#define INF INT_MAX
+#endif
+
+typedef unsigned int ui;
+
+// unreachable distance for the sparse engines, small enough that INF_DIST + INF_DIST does not overflow
+constexpr long long INF_DIST = LLONG_MAX / 4;
+
+/**
+ * A directed weighted edge u -> v
+ */
+struct Edge {
+    ui u, v;
+    long long w;
+};
+
+/**
+ * A static directed graph in compressed sparse row form
+ * The out-arcs of u are to[offset[u]] ... to[offset[u + 1] - 1]
+ * Parallel edges are merged on construction, keeping the minimum weight
+ */
+class CSRGraph {
+public:
+    ui n = 0;
+    std::vector<ui> offset;
+    std::vector<ui> to;
+    std::vector<long long> weight;
+
+    CSRGraph() = default;
+
+    /**
+     * Radix sort the edges by (u, v) and reduce parallel edges to their minimum weight
+     * Time Complexity: O(m + n)
+     * @param n number of vertices
+     * @param edges we pass by value here because edges need to be sorted
+     */
+    CSRGraph(ui n, std::vector<Edge> edges) : n(n), offset(n + 1, 0) {
+        std::vector<Edge> buffer(edges.size());
+        // LSD passes over the bytes of v, constant bytes are skipped
+        for (unsigned shift = 0; shift < 32; shift += 8) {
+            size_t count[257] = {0};
+            for (auto &e : edges) ++count[((e.v >> shift) & 0xff) + 1];
+            if (std::find(count + 1, count + 257, edges.size()) != count + 257) continue;
+            for (int b = 0; b < 256; b++) count[b + 1] += count[b];
+            for (auto &e : edges) buffer[count[(e.v >> shift) & 0xff]++] = e;
+            edges.swap(buffer);
+        }
+        // the last, stable, pass is a counting sort by u that directly yields the row offsets
+        std::vector<ui> start(n + 1, 0);
+        for (auto &e : edges) ++start[e.u + 1];
+        for (ui u = 0; u < n; u++) start[u + 1] += start[u];
+        for (auto &e : edges) buffer[start[e.u]++] = e;
+        to.reserve(edges.size());
+        weight.reserve(edges.size());
+        for (size_t i = 0; i < buffer.size(); i++) {
+            const Edge &e = buffer[i];
+            if (i > 0 && e.u == buffer[i - 1].u && e.v == to.back()) {
+                if (e.w < weight.back()) weight.back() = e.w;
+                continue;
+            }
+            ++offset[e.u + 1];
+            to.push_back(e.v);
+            weight.push_back(e.w);
+        }
+        for (ui u = 0; u < n; u++) offset[u + 1] += offset[u];
+    }
+
+    size_t edgeCount() const { return to.size(); }
+
+    ui degree(ui u) const { return offset[u + 1] - offset[u]; }
+
+    /**
+     * Time Complexity: O(log d)
+     * @return the index of arc u -> v, or edgeCount() if there is none
+     */
+    size_t arc(ui u, ui v) const {
+        auto first = to.begin() + offset[u], last = to.begin() + offset[u + 1];
+        auto it = std::lower_bound(first, last, v);
+        return it != last && *it == v ? static_cast<size_t>(it - to.begin()) : to.size();
+    }
+
+    /**
+     * @return every arc as an edge list
+     */
+    std::vector<Edge> edges() const {
+        std::vector<Edge> edges;
+        edges.reserve(to.size());
+        for (ui u = 0; u < n; u++)
+            for (ui i = offset[u]; i < offset[u + 1]; i++)
+                edges.push_back({u, to[i], weight[i]});
+        return edges;
+    }
+
+    /**
+     * @return the graph with every arc reversed
+     */
+    CSRGraph reverse() const {
+        std::vector<Edge> edges = this->edges();
+        for (auto &e : edges) std::swap(e.u, e.v);
+        return CSRGraph(n, std::move(edges));
+    }
+
+    /**
+     * Time Complexity: O(n + m)
+     * @param rank new id of every vertex, a permutation of 0 .. n - 1
+     * @return the same graph with vertex v renamed to rank[v]
+     */
+    CSRGraph relabel(const std::vector<ui> &rank) const {
+        std::vector<Edge> edges = this->edges();
+        for (auto &e : edges) {
+            e.u = rank[e.u];
+            e.v = rank[e.v];
+        }
+        return CSRGraph(n, std::move(edges));
+    }
+
+    size_t memoryUsage() const {
+        return offset.capacity() * sizeof(ui) + to.capacity() * sizeof(ui)
+               + weight.capacity() * sizeof(long long);
+    }
+};
+
+/**
+ * Strongly connected components by an iterative Tarjan search
+ * Components are numbered in reverse topological order of the condensation DAG:
+ * if v is reachable from u then comp[v] <= comp[u], so comp[v] > comp[u] proves that v is unreachable from u
+ * Time Complexity: O(n + m)
+ * @param g
+ * @param comp output component of every vertex
+ * @return the number of components
+ */
+inline ui stronglyConnectedComponents(const CSRGraph &g, std::vector<ui> &comp) {
+    ui n = g.n, count = 0, counter = 0;
+    const ui unvisited = n;
+    comp.assign(n, unvisited);
+    std::vector<ui> index(n, unvisited), low(n), stack, callStack, nextArc(n);
+    stack.reserve(n);
+    for (ui root = 0; root < n; root++) {
+        if (index[root] != unvisited) continue;
+        callStack.push_back(root);
+        index[root] = low[root] = counter++;
+        nextArc[root] = g.offset[root];
+        stack.push_back(root);
+        while (!callStack.empty()) {
+            ui u = callStack.back();
+            if (nextArc[u] < g.offset[u + 1]) {
+                ui v = g.to[nextArc[u]++];
+                if (index[v] == unvisited) {
+                    index[v] = low[v] = counter++;
+                    nextArc[v] = g.offset[v];
+                    stack.push_back(v);
+                    callStack.push_back(v);
+                }
+                else if (comp[v] == unvisited) {
+                    // v is still on the stack
+                    low[u] = std::min(low[u], index[v]);
+                }
+                continue;
+            }
+            callStack.pop_back();
+            if (!callStack.empty()) low[callStack.back()] = std::min(low[callStack.back()], low[u]);
+            if (low[u] != index[u]) continue;
+            ui v;
+            do {
+                v = stack.back();
+                stack.pop_back();
+                comp[v] = count;
+            } while (v != u);
+            ++count;
+        }
+    }
+    return count;
+}
+
+/**
+ * Finds cycles in the parent pointers of a label-correcting search: with strictly improving labels,
+ * a cycle of parent pointers is a negative cycle
+ * Each check walks every pointer at most once, so running one per `count` relaxations is O(1) amortized
+ */
+class ParentCycleCheck {
+public:
+    explicit ParentCycleCheck(ui n) : stamp(n, 0) {}
+
+    /**
+     * Time Complexity: O(number of vertices walked)
+     * @param first, last the vertices whose parent pointers may form a cycle
+     * @param parent parent pointers, parent.size() for none
+     */
+    template<typename It>
+    bool found(It first, It last, const std::vector<ui> &parent) {
+        const ui none = static_cast<ui>(parent.size());
+        const size_t begin = walks + 1;
+        for (; first != last; ++first) {
+            const size_t id = ++walks;
+            ui u = *first;
+            while (u != none && stamp[u] < begin) {
+                stamp[u] = id;
+                u = parent[u];
+            }
+            if (u != none && stamp[u] == id) return true;
+        }
+        return false;
+    }
+
+private:
+    std::vector<size_t> stamp;  // the walk that last visited a vertex
+    size_t walks = 0;
+};
+
+namespace LabelCorrecting {
+    struct Stats {
+        size_t scans = 0;           // vertices whose out-arcs were scanned
+        size_t relaxations = 0;     // labels improved
+    };
+}
+
+/**
+ * Compute Johnson potentials h with a virtual source connected to every vertex by a 0-weight arc,
+ * so that w(u, v) + h[u] - h[v] >= 0 for every arc
+ * A negative cycle lies inside one strongly connected component, so the Bellman-Ford queue runs one component
+ * at a time, in topological order, and arcs between components are relaxed once their tail component is final.
+ * Inside a component, a parent-pointer walk every `size` relaxations finds negative cycles early,
+ * and a tentative path of `size` arcs guarantees termination
+ * Time Complexity: O(n + m) plus O(size * arcs) per component worst case
+ * @param g
+ * @param h output potentials
+ * @param stats optional counters, comparable with those of LabelCorrecting::bellmanFord and spfa
+ * @return false if the graph contains a negative cycle
+ */
+inline bool johnsonPotentials(const CSRGraph &g, std::vector<long long> &h,
+                              LabelCorrecting::Stats *stats = nullptr) {
+    ui n = g.n;
+    h.assign(n, 0);
+    if (n == 0) return true;
+    std::vector<ui> comp;
+    ui count = stronglyConnectedComponents(g, comp);
+    // members of every component, components in topological order (decreasing number)
+    std::vector<ui> start(count + 1, 0), members(n);
+    for (ui v = 0; v < n; v++) ++start[count - comp[v]];
+    for (ui c = 0; c < count; c++) start[c + 1] += start[c];
+    for (ui v = 0; v < n; v++) members[start[count - 1 - comp[v]]++] = v;
+    for (ui c = count; c > 0; c--) start[c] = start[c - 1];
+    start[0] = 0;
+
+    // len[v] is the number of arcs inside the component on the current shortest path to v
+    std::vector<ui> len(n, 0), parent(n, n);
+    std::vector<char> inQueue(n, 0);
+    std::vector<ui> queue(n);
+    ParentCycleCheck cycles(n);
+    for (ui c = 0; c < count; c++) {
+        const ui first = start[c], size = start[c + 1] - first, id = comp[members[first]];
+        if (size > 1) {
+            for (ui i = 0; i < size; i++) {
+                queue[i] = members[first + i];
+                inQueue[queue[i]] = 1;
+            }
+            size_t head = 0, pending = size, untilCheck = size;
+            while (pending > 0) {
+                ui u = queue[head];
+                head = head + 1 == size ? 0 : head + 1;
+                --pending;
+                inQueue[u] = 0;
+                if (stats) ++stats->scans;
+                for (ui i = g.offset[u]; i < g.offset[u + 1]; i++) {
+                    ui v = g.to[i];
+                    if (comp[v] != id || h[u] + g.weight[i] >= h[v]) continue;
+                    h[v] = h[u] + g.weight[i];
+                    if (stats) ++stats->relaxations;
+                    len[v] = len[u] + 1;
+                    parent[v] = u;
+                    // a shortest simple path inside the component has at most size - 1 arcs
+                    if (len[v] >= size) return false;
+                    if (--untilCheck == 0) {
+                        untilCheck = size;
+                        if (cycles.found(&members[first], &members[first] + size, parent)) return false;
+                    }
+                    if (!inQueue[v]) {
+                        inQueue[v] = 1;
+                        queue[(head + pending) % size] = v;
+                        ++pending;
+                    }
+                }
+            }
+        }
+        for (ui k = first; k < first + size; k++) {
+            ui u = members[k];
+            if (stats) ++stats->scans;
+            for (ui i = g.offset[u]; i < g.offset[u + 1]; i++) {
+                ui v = g.to[i];
+                if (v == u && g.weight[i] < 0) return false;
+                if (comp[v] != id && h[u] + g.weight[i] < h[v]) {
+                    h[v] = h[u] + g.weight[i];
+                    if (stats) ++stats->relaxations;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Dijkstra from s on a graph with nonnegative weights
+ * Time Complexity: O(m log n)
+ * @param g
+ * @param s
+ * @param dist output distances, INF_DIST if unreachable
+ * @param parent optional output shortest path tree, parent[s] = parent[unreachable] = n
+ */
+inline void dijkstra(const CSRGraph &g, ui s, std::vector<long long> &dist, std::vector<ui> *parent = nullptr) {
+    typedef std::pair<long long, ui> Item;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> q;
+    dist.assign(g.n, INF_DIST);
+    if (parent) parent->assign(g.n, g.n);
+    dist[s] = 0;
+    q.emplace(0, s);
+    while (!q.empty()) {
+        long long d = q.top().first;
+        ui u = q.top().second;
+        q.pop();
+        if (d > dist[u]) continue;
+        for (ui i = g.offset[u]; i < g.offset[u + 1]; i++) {
+            ui v = g.to[i];
+            if (d + g.weight[i] < dist[v]) {
+                dist[v] = d + g.weight[i];
+                if (parent) (*parent)[v] = u;
+                q.emplace(dist[v], v);
+            }
+        }
+    }
+}
+
+/**
+ * Dijkstra from s on a graph with arbitrary weights, given feasible potentials h (see johnsonPotentials)
+ * Time Complexity: O(m log n)
+ * @param g
+ * @param h potentials with w(u, v) + h[u] - h[v] >= 0
+ * @param s
+ * @param dist output true distances (not reduced), INF_DIST if unreachable
+ * @param parent optional output shortest path tree, parent[s] = parent[unreachable] = n
+ */
+inline void dijkstra(const CSRGraph &g, const std::vector<long long> &h, ui s, std::vector<long long> &dist,
+                     std::vector<ui> *parent = nullptr) {
+    typedef std::pair<long long, ui> Item;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> q;
+    // dist holds reduced distances during the search
+    dist.assign(g.n, INF_DIST);
+    if (parent) parent->assign(g.n, g.n);
+    dist[s] = 0;
+    q.emplace(0, s);
+    while (!q.empty()) {
+        long long d = q.top().first;
+        ui u = q.top().second;
+        q.pop();
+        if (d > dist[u]) continue;
+        for (ui i = g.offset[u]; i < g.offset[u + 1]; i++) {
+            ui v = g.to[i];
+            long long nd = d + g.weight[i] + h[u] - h[v];
+            if (nd < dist[v]) {
+                dist[v] = nd;
+                if (parent) (*parent)[v] = u;
+                q.emplace(nd, v);
+            }
+        }
+    }
+    for (ui v = 0; v < g.n; v++)
+        if (dist[v] != INF_DIST) dist[v] += h[v] - h[s];
+}
+
+/**
+ * @return g with every arc reweighted to w(u, v) + h[u] - h[v]
+ */
+inline CSRGraph reweight(const CSRGraph &g, const std::vector<long long> &h) {
+    CSRGraph r = g;
+    for (ui u = 0; u < g.n; u++)
+        for (ui i = g.offset[u]; i < g.offset[u + 1]; i++)
+            r.weight[i] += h[u] - h[g.to[i]];
+    return r;
+}
+
+#endif //VE281P4_GRAPH_HPP
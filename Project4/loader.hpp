@@ -0,0 +1,235 @@
+#ifndef VE281P4_LOADER_HPP
+#define VE281P4_LOADER_HPP
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include <streambuf>
+#include <stdexcept>
+#include "graph.hpp"
+
+/**
+ * Graph loaders
+ *
+ * Text format (the readGraph format): n, m, then m lines "u v w"
+ * Binary format: 32-byte header {magic "VE281EDG", uint32 version, uint32 n, uint64 m, 8 reserved bytes}
+ * followed by m packed 12-byte records {uint32 u, uint32 v, int32 w}, little endian, so weights must fit in 32 bits
+ */
+namespace GraphLoader {
+    constexpr char BINARY_MAGIC[8] = {'V', 'E', '2', '8', '1', 'E', 'D', 'G'};
+    constexpr uint32_t BINARY_VERSION = 1;
+
+    struct BinaryHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t n;
+        uint64_t m;
+        unsigned char reserved[8];
+    };
+    static_assert(sizeof(BinaryHeader) == 32, "header must be 32 bytes");
+
+    struct BinaryEdge {
+        uint32_t u, v;
+        int32_t w;
+    };
+    static_assert(sizeof(BinaryEdge) == 12, "records must be packed");
+
+    // records converted per fread or fwrite of a binary edge list
+    constexpr size_t BINARY_BLOCK = 1 << 16;
+    // most edges reserved up front from the count in a text header, which nothing checks before the edges arrive
+    constexpr size_t TEXT_RESERVE = 1 << 20;
+
+    /**
+     * Character source over a stream buffer, leaves the stream positioned right after the last parsed token
+     * With std::ios::sync_with_stdio(false), std::cin's buffer is a block-buffered filebuf
+     */
+    class StreambufSource {
+    public:
+        explicit StreambufSource(std::streambuf *buf) : buf(buf) {}
+
+        int peek() { return buf->sgetc(); }
+
+        void next() { buf->sbumpc(); }
+
+    private:
+        std::streambuf *buf;
+    };
+
+    /**
+     * Character source reading a file in large blocks
+     */
+    class FileSource {
+    public:
+        explicit FileSource(FILE *file) : file(file), buffer(BLOCK) { fill(); }
+
+        int peek() { return pos < size ? buffer[pos] : EOF; }
+
+        void next() {
+            if (++pos >= size) fill();
+        }
+
+    private:
+        static constexpr size_t BLOCK = 1 << 20;
+
+        FILE *file;
+        std::vector<unsigned char> buffer;
+        size_t pos = 0, size = 0;
+
+        void fill() {
+            pos = 0;
+            size = std::fread(buffer.data(), 1, BLOCK, file);
+        }
+    };
+
+    /**
+     * Parse a signed integer, skipping any leading non-digit characters except '-'
+     * @throw std::runtime_error on end of input or a value out of the range of long long
+     */
+    template<typename Source>
+    long long readInt(Source &src) {
+        int ch = src.peek();
+        while (ch != EOF && ch != '-' && (ch < '0' || ch > '9')) {
+            src.next();
+            ch = src.peek();
+        }
+        if (ch == EOF) throw std::runtime_error("unexpected end of graph input");
+        bool negative = ch == '-';
+        if (negative) {
+            src.next();
+            ch = src.peek();
+        }
+        long long x = 0;
+        for (; ch >= '0' && ch <= '9'; src.next(), ch = src.peek()) {
+            if (x > (LLONG_MAX - (ch - '0')) / 10) throw std::runtime_error("integer out of range in graph input");
+            x = x * 10 + (ch - '0');
+        }
+        return negative ? -x : x;
+    }
+
+    /**
+     * Parse a text edge list
+     * The edge count of the header is only trusted as far as edges follow it, memory grows with the edges read
+     * @throw std::runtime_error on truncated input, a count out of range or out-of-range vertices
+     */
+    template<typename Source>
+    void readText(Source &src, ui &n, std::vector<Edge> &edges) {
+        long long vertices = readInt(src);
+        if (vertices < 0 || vertices > static_cast<long long>(UINT_MAX))
+            throw std::runtime_error("vertex count out of range in graph input");
+        long long m = readInt(src);
+        if (m < 0) throw std::runtime_error("edge count out of range in graph input");
+        n = static_cast<ui>(vertices);
+        edges.clear();
+        edges.reserve(std::min(static_cast<size_t>(m), TEXT_RESERVE));
+        for (long long k = 0; k < m; k++) {
+            long long u = readInt(src), v = readInt(src), w = readInt(src);
+            if (u < 0 || v < 0 || u >= vertices || v >= vertices)
+                throw std::runtime_error("vertex out of range in graph input");
+            edges.push_back({static_cast<ui>(u), static_cast<ui>(v), w});
+        }
+    }
+
+    /**
+     * Load a text or binary edge list file, the format is detected from the magic
+     * @throw std::runtime_error
+     */
+    inline void load(const std::string &path, ui &n, std::vector<Edge> &edges) {
+        FILE *file = std::fopen(path.c_str(), "rb");
+        if (file == nullptr) throw std::runtime_error("cannot open " + path);
+        BinaryHeader header;
+        size_t got = std::fread(&header, 1, sizeof(header), file);
+        if (got == sizeof(header) && std::memcmp(header.magic, BINARY_MAGIC, sizeof(header.magic)) == 0) {
+            if (header.version != BINARY_VERSION) {
+                std::fclose(file);
+                throw std::runtime_error("unsupported binary graph version in " + path);
+            }
+            // the edge count is checked against the file size before anything is allocated for it
+            long size = std::fseek(file, 0, SEEK_END) == 0 ? std::ftell(file) : -1;
+            if (size < static_cast<long>(sizeof(header))
+                || header.m > (static_cast<uint64_t>(size) - sizeof(header)) / sizeof(BinaryEdge)
+                || std::fseek(file, sizeof(header), SEEK_SET) != 0) {
+                std::fclose(file);
+                throw std::runtime_error("truncated binary graph " + path);
+            }
+            n = header.n;
+            edges.resize(header.m);
+            std::vector<BinaryEdge> records(std::min<uint64_t>(header.m, BINARY_BLOCK));
+            for (size_t first = 0; first < edges.size(); first += records.size()) {
+                size_t count = std::min(records.size(), edges.size() - first);
+                if (std::fread(records.data(), sizeof(BinaryEdge), count, file) != count) {
+                    std::fclose(file);
+                    throw std::runtime_error("truncated binary graph " + path);
+                }
+                for (size_t i = 0; i < count; i++) {
+                    edges[first + i] = {records[i].u, records[i].v, records[i].w};
+                    if (records[i].u >= n || records[i].v >= n) {
+                        std::fclose(file);
+                        throw std::runtime_error("vertex out of range in " + path);
+                    }
+                }
+            }
+            std::fclose(file);
+            return;
+        }
+        std::rewind(file);
+        FileSource src(file);
+        try {
+            readText(src, n, edges);
+        }
+        catch (...) {
+            std::fclose(file);
+            throw;
+        }
+        std::fclose(file);
+    }
+
+    /**
+     * Write an edge list in the text format
+     * @throw std::runtime_error
+     */
+    inline void saveText(const std::string &path, ui n, const std::vector<Edge> &edges) {
+        FILE *file = std::fopen(path.c_str(), "w");
+        if (file == nullptr) throw std::runtime_error("cannot open " + path);
+        bool ok = std::fprintf(file, "%u\n%zu\n", n, edges.size()) > 0;
+        for (size_t i = 0; i < edges.size() && ok; i++)
+            ok = std::fprintf(file, "%u %u %lld\n", edges[i].u, edges[i].v, edges[i].w) > 0;
+        ok = std::fclose(file) == 0 && ok;
+        if (!ok) throw std::runtime_error("cannot write " + path);
+    }
+
+    /**
+     * Write an edge list in the binary format
+     * @throw std::runtime_error if the file can not be written or a weight does not fit in 32 bits
+     */
+    inline void saveBinary(const std::string &path, ui n, const std::vector<Edge> &edges) {
+        for (const auto &e : edges) {
+            if (e.w < INT32_MIN || e.w > INT32_MAX)
+                throw std::runtime_error("weight " + std::to_string(e.w) + " does not fit the binary graph format");
+        }
+        FILE *file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr) throw std::runtime_error("cannot open " + path);
+        BinaryHeader header = {};
+        std::memcpy(header.magic, BINARY_MAGIC, sizeof(header.magic));
+        header.version = BINARY_VERSION;
+        header.n = n;
+        header.m = edges.size();
+        bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+        std::vector<BinaryEdge> records(std::min(edges.size(), BINARY_BLOCK));
+        for (size_t first = 0; first < edges.size() && ok; first += records.size()) {
+            size_t count = std::min(records.size(), edges.size() - first);
+            for (size_t i = 0; i < count; i++) {
+                const Edge &e = edges[first + i];
+                records[i] = {e.u, e.v, static_cast<int32_t>(e.w)};
+            }
+            ok = std::fwrite(records.data(), sizeof(BinaryEdge), count, file) == count;
+        }
+        ok = std::fclose(file) == 0 && ok;
+        if (!ok) throw std::runtime_error("cannot write " + path);
+    }
+}
+
+#endif //VE281P4_LOADER_HPP
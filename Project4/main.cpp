@@ -3,6 +3,7 @@
 using namespace std;
 
 int main () {
+	ios::sync_with_stdio(false);
 	ShortestP2P a;
 	a.readGraph();
 
@@ -0,0 +1,113 @@
+#ifndef VE281P4_MATRIX_HPP
+#define VE281P4_MATRIX_HPP
+
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <utility>
+#include "graph.hpp"
+#include "../common/large_pages.hpp"
+
+/**
+ * A dense n x n distance matrix in one contiguous, cache-line-aligned block
+ * Every row starts on a cache line (the stride is padded), so row scans in Floyd-Warshall never split lines
+ * The maximum value of Dist is the unreachable sentinel, additions through add() saturate at it
+ * Large matrices are mapped through LargePages with the policy given to setPagePolicy (the default policy otherwise)
+ * @tparam Dist distance type, int when every finite distance fits in 32 bits, long long otherwise
+ */
+template<typename Dist>
+class DistanceMatrix {
+public:
+    static constexpr Dist INF_VALUE = std::numeric_limits<Dist>::max();
+    static constexpr size_t ALIGNMENT = 64;
+
+    DistanceMatrix() = default;
+
+    explicit DistanceMatrix(ui n) { reset(n); }
+
+    DistanceMatrix(const DistanceMatrix &) = delete;
+
+    DistanceMatrix &operator=(const DistanceMatrix &) = delete;
+
+    DistanceMatrix(DistanceMatrix &&that) noexcept { swap(that); }
+
+    DistanceMatrix &operator=(DistanceMatrix &&that) noexcept {
+        swap(that);
+        return *this;
+    }
+
+    ~DistanceMatrix() { LargePages::deallocate(data, bytes()); }
+
+    /**
+     * Page policy of the allocations from now on, the current block keeps its pages
+     */
+    void setPagePolicy(const LargePages::Policy &policy) { pagePolicy = policy; }
+
+    const LargePages::Policy &policy() const { return pagePolicy; }
+
+    /**
+     * Reallocate to n x n and fill with INF_VALUE
+     * Time Complexity: O(n^2)
+     * @throw std::bad_alloc
+     */
+    void reset(ui n) {
+        LargePages::deallocate(data, bytes());
+        data = nullptr;
+        this->n = n;
+        rowStride = (static_cast<size_t>(n) * sizeof(Dist) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT / sizeof(Dist);
+        if (n == 0) return;
+        data = static_cast<Dist *>(LargePages::allocate(bytes(), ALIGNMENT, pagePolicy));
+        for (size_t i = 0; i < static_cast<size_t>(n) * rowStride; i++) data[i] = INF_VALUE;
+    }
+
+    Dist *row(ui i) { return data + static_cast<size_t>(i) * rowStride; }
+
+    const Dist *row(ui i) const { return data + static_cast<size_t>(i) * rowStride; }
+
+    Dist &operator()(ui i, ui j) { return row(i)[j]; }
+
+    const Dist &operator()(ui i, ui j) const { return row(i)[j]; }
+
+    ui size() const { return n; }
+
+    size_t stride() const { return rowStride; }
+
+    size_t bytes() const { return static_cast<size_t>(n) * rowStride * sizeof(Dist); }
+
+    /**
+     * Saturating addition, INF_VALUE absorbs everything and overflow clamps to the representable range
+     */
+    static Dist add(Dist a, Dist b) {
+        if (a == INF_VALUE || b == INF_VALUE) return INF_VALUE;
+        Dist c;
+        if (__builtin_add_overflow(a, b, &c)) return a < 0 ? std::numeric_limits<Dist>::min() : INF_VALUE;
+        return c;
+    }
+
+    /**
+     * Whether every finite distance of a graph, and the sum of any two of them, is representable in Dist
+     * @param n number of vertices
+     * @param maxAbs maximum absolute edge weight
+     */
+    static bool fits(ui n, long long maxAbs) {
+        if (n <= 1 || maxAbs == 0) return true;
+        return maxAbs <= static_cast<long long>(INF_VALUE / 2) / static_cast<long long>(n - 1);
+    }
+
+protected:
+    Dist *data = nullptr;
+    ui n = 0;
+    size_t rowStride = 0;
+    LargePages::Policy pagePolicy = LargePages::defaultPolicy();
+
+    void swap(DistanceMatrix &that) {
+        std::swap(data, that.data);
+        std::swap(n, that.n);
+        std::swap(rowStride, that.rowStride);
+        // a moved block keeps the policy it was mapped with
+        std::swap(pagePolicy, that.pagePolicy);
+    }
+};
+
+#endif //VE281P4_MATRIX_HPP
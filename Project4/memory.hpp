@@ -0,0 +1,32 @@
+#ifndef VE281P4_MEMORY_HPP
+#define VE281P4_MEMORY_HPP
+
+#include <cstddef>
+#include <unistd.h>
+#include <sys/resource.h>
+
+/**
+ * Process memory figures from the operating system, no allocation hooks involved
+ */
+namespace Memory {
+    /**
+     * @return bytes of physical memory, 0 if unknown
+     */
+    inline size_t physicalBytes() {
+        long pages = sysconf(_SC_PHYS_PAGES), size = sysconf(_SC_PAGE_SIZE);
+        if (pages <= 0 || size <= 0) return 0;
+        return static_cast<size_t>(pages) * static_cast<size_t>(size);
+    }
+
+    /**
+     * @return the peak resident set size of this process so far, 0 if unknown
+     */
+    inline size_t peakResidentBytes() {
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+        // ru_maxrss is in kilobytes on Linux
+        return static_cast<size_t>(usage.ru_maxrss) * 1024;
+    }
+}
+
+#endif //VE281P4_MEMORY_HPP
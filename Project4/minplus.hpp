@@ -0,0 +1,229 @@
+#ifndef VE281P4_MINPLUS_HPP
+#define VE281P4_MINPLUS_HPP
+
+#include <algorithm>
+#include "matrix.hpp"
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+/**
+ * Min-plus (tropical) matrix product C = min(C, A (x) B), where (A (x) B)(i, j) = min_k A(i, k) + B(k, j)
+ *
+ * The loop nest follows a GEMM: a KC x NC panel of B and an MC x KC block of A stay in cache while a micro-kernel
+ * keeps an MR x NR tile of C in registers for the whole depth of the panel.
+ * NR is one cache line of Dist, so a tile never crosses the padded row stride of DistanceMatrix.
+ * The int micro-kernel is written with AVX-512 or AVX2 intrinsics when the target has them,
+ * every other case uses a portable kernel that the compiler vectorizes.
+ *
+ * INF_VALUE absorbs every addition; finite sums must not overflow, which DistanceMatrix::fits() guarantees for
+ * distances of a graph without negative cycles.
+ */
+namespace MinPlus {
+    constexpr ui MC = 64;
+    constexpr ui KC = 256;
+    constexpr ui NC = 512;
+
+    /**
+     * Portable MR x NR micro-kernel over depth steps: c[r][j] = min(c[r][j], a[r][k] + b[k][j])
+     * @param rows number of valid rows of the tile, at most MR
+     */
+    template<typename Dist, ui MR, ui NR>
+    inline void kernel(const Dist *a, size_t lda, const Dist *b, size_t ldb, Dist *c, size_t ldc,
+                       ui rows, ui depth) {
+        const Dist inf = DistanceMatrix<Dist>::INF_VALUE;
+        Dist acc[MR][NR];
+        for (ui r = 0; r < rows; r++)
+            for (ui j = 0; j < NR; j++) acc[r][j] = c[r * ldc + j];
+        for (ui k = 0; k < depth; k++) {
+            const Dist *bk = b + k * ldb;
+            for (ui r = 0; r < rows; r++) {
+                const Dist ark = a[r * lda + k];
+                if (ark == inf) continue;
+                for (ui j = 0; j < NR; j++) {
+                    Dist t = bk[j] == inf ? inf : static_cast<Dist>(ark + bk[j]);
+                    acc[r][j] = t < acc[r][j] ? t : acc[r][j];
+                }
+            }
+        }
+        for (ui r = 0; r < rows; r++)
+            for (ui j = 0; j < NR; j++) c[r * ldc + j] = acc[r][j];
+    }
+
+#if defined(__AVX512F__)
+    /**
+     * 8 x 16 int micro-kernel, one zmm register per row of C
+     */
+    inline void kernelInt(const int *a, size_t lda, const int *b, size_t ldb, int *c, size_t ldc,
+                          ui rows, ui depth) {
+        constexpr ui MR = 8;
+        const __m512i inf = _mm512_set1_epi32(DistanceMatrix<int>::INF_VALUE);
+        __m512i acc[MR] = {};
+        for (ui r = 0; r < rows; r++) acc[r] = _mm512_load_si512(c + r * ldc);
+        for (ui k = 0; k < depth; k++) {
+            const __m512i bk = _mm512_load_si512(b + k * ldb);
+            const __mmask16 bInf = _mm512_cmpeq_epi32_mask(bk, inf);
+            for (ui r = 0; r < rows; r++) {
+                const int ark = a[r * lda + k];
+                if (ark == DistanceMatrix<int>::INF_VALUE) continue;
+                __m512i t = _mm512_mask_blend_epi32(bInf, _mm512_add_epi32(_mm512_set1_epi32(ark), bk), inf);
+                // the masked form with a full mask is the same vpminsd; GCC's unmasked intrinsic passes an
+                // undefined register through, which -Wmaybe-uninitialized reports at every call site
+                acc[r] = _mm512_mask_min_epi32(acc[r], 0xFFFF, acc[r], t);
+            }
+        }
+        for (ui r = 0; r < rows; r++) _mm512_store_si512(c + r * ldc, acc[r]);
+    }
+
+    constexpr ui INT_MR = 8;
+#elif defined(__AVX2__)
+    /**
+     * 4 x 16 int micro-kernel, two ymm registers per row of C
+     */
+    inline void kernelInt(const int *a, size_t lda, const int *b, size_t ldb, int *c, size_t ldc,
+                          ui rows, ui depth) {
+        constexpr ui MR = 4;
+        const __m256i inf = _mm256_set1_epi32(DistanceMatrix<int>::INF_VALUE);
+        __m256i lo[MR] = {}, hi[MR] = {};
+        for (ui r = 0; r < rows; r++) {
+            lo[r] = _mm256_load_si256(reinterpret_cast<const __m256i *>(c + r * ldc));
+            hi[r] = _mm256_load_si256(reinterpret_cast<const __m256i *>(c + r * ldc + 8));
+        }
+        for (ui k = 0; k < depth; k++) {
+            const __m256i bLo = _mm256_load_si256(reinterpret_cast<const __m256i *>(b + k * ldb));
+            const __m256i bHi = _mm256_load_si256(reinterpret_cast<const __m256i *>(b + k * ldb + 8));
+            const __m256i infLo = _mm256_cmpeq_epi32(bLo, inf), infHi = _mm256_cmpeq_epi32(bHi, inf);
+            for (ui r = 0; r < rows; r++) {
+                const int ark = a[r * lda + k];
+                if (ark == DistanceMatrix<int>::INF_VALUE) continue;
+                const __m256i x = _mm256_set1_epi32(ark);
+                lo[r] = _mm256_min_epi32(lo[r], _mm256_blendv_epi8(_mm256_add_epi32(x, bLo), inf, infLo));
+                hi[r] = _mm256_min_epi32(hi[r], _mm256_blendv_epi8(_mm256_add_epi32(x, bHi), inf, infHi));
+            }
+        }
+        for (ui r = 0; r < rows; r++) {
+            _mm256_store_si256(reinterpret_cast<__m256i *>(c + r * ldc), lo[r]);
+            _mm256_store_si256(reinterpret_cast<__m256i *>(c + r * ldc + 8), hi[r]);
+        }
+    }
+
+    constexpr ui INT_MR = 4;
+#endif
+
+    template<typename Dist>
+    struct Kernel {
+        static constexpr ui MR = 4;
+        static constexpr ui NR = DistanceMatrix<Dist>::ALIGNMENT / sizeof(Dist);
+
+        static void run(const Dist *a, size_t lda, const Dist *b, size_t ldb, Dist *c, size_t ldc,
+                        ui rows, ui depth) {
+            kernel<Dist, MR, NR>(a, lda, b, ldb, c, ldc, rows, depth);
+        }
+    };
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+    template<>
+    struct Kernel<int> {
+        static constexpr ui MR = INT_MR;
+        static constexpr ui NR = 16;
+
+        static void run(const int *a, size_t lda, const int *b, size_t ldb, int *c, size_t ldc,
+                        ui rows, ui depth) {
+            kernelInt(a, lda, b, ldb, c, ldc, rows, depth);
+        }
+    };
+#endif
+
+    /**
+     * C = min(C, A (x) B) for n x n matrices; C must not alias A or B
+     * Time Complexity: O(n^3)
+     */
+    template<typename Dist>
+    void multiply(const DistanceMatrix<Dist> &A, const DistanceMatrix<Dist> &B, DistanceMatrix<Dist> &C) {
+        typedef Kernel<Dist> K;
+        const ui n = A.size();
+        // columns are processed in whole tiles, the padding of every row makes the last tile addressable
+        const ui cols = static_cast<ui>((n + K::NR - 1) / K::NR * K::NR);
+        for (ui jc = 0; jc < cols; jc += NC) {
+            const ui nc = std::min(NC, cols - jc);
+            for (ui pc = 0; pc < n; pc += KC) {
+                const ui kc = std::min(KC, n - pc);
+                for (ui ic = 0; ic < n; ic += MC) {
+                    const ui mc = std::min(MC, n - ic);
+                    for (ui jr = 0; jr < nc; jr += K::NR) {
+                        for (ui ir = 0; ir < mc; ir += K::MR) {
+                            K::run(A.row(ic + ir) + pc, A.stride(), B.row(pc) + jc + jr, B.stride(),
+                                   C.row(ic + ir) + jc + jr, C.stride(), std::min(K::MR, mc - ir), kc);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * Turn D, the one-hop matrix (arc weights and a zero diagonal), into the matrix of distances over at most
+     * `hops` arcs by binary exponentiation; any hops >= n - 1 gives all-pairs shortest distances
+     * Time Complexity: O(n^3 log hops)
+     * @param D in: one-hop matrix, out: hop-bounded distances
+     */
+    template<typename Dist>
+    void hopBounded(DistanceMatrix<Dist> &D, ui hops) {
+        const ui n = D.size();
+        if (hops == 0) {
+            D.reset(n);
+            for (ui i = 0; i < n; i++) D(i, i) = 0;
+            return;
+        }
+        if (hops == 1) return;
+        // every product is mapped with the page policy of D
+        DistanceMatrix<Dist> power(std::move(D)), result, scratch;
+        result.setPagePolicy(power.policy());
+        scratch.setPagePolicy(power.policy());
+        result.reset(n);
+        bool identity = true;   // result is still the min-plus identity
+        for (ui e = hops; e > 0; e >>= 1) {
+            if (e & 1) {
+                if (identity) {
+                    for (ui i = 0; i < n; i++) std::copy(power.row(i), power.row(i) + n, result.row(i));
+                    identity = false;
+                }
+                else {
+                    scratch.reset(n);
+                    multiply(result, power, scratch);
+                    std::swap(result, scratch);
+                }
+            }
+            if (e > 1) {
+                scratch.reset(n);
+                multiply(power, power, scratch);
+                std::swap(power, scratch);
+            }
+        }
+        D = std::move(result);
+    }
+
+    /**
+     * All-pairs shortest distances of a one-hop matrix without negative cycles by repeated squaring:
+     * D_{2h} = D_h (x) D_h, at most ceil(log2(n - 1)) products, fewer when every shortest path has few arcs
+     * Time Complexity: O(n^3 log n)
+     */
+    template<typename Dist>
+    void allPairs(DistanceMatrix<Dist> &D) {
+        const ui n = D.size();
+        DistanceMatrix<Dist> scratch;
+        scratch.setPagePolicy(D.policy());
+        for (ui hops = 1; hops + 1 < n; hops *= 2) {
+            scratch.reset(n);
+            multiply(D, D, scratch);
+            std::swap(D, scratch);
+            // a fixed point: no shortest path needs more arcs than already covered
+            bool changed = false;
+            for (ui i = 0; i < n && !changed; i++) changed = !std::equal(D.row(i), D.row(i) + n, scratch.row(i));
+            if (!changed) break;
+        }
+    }
+}
+
+#endif //VE281P4_MINPLUS_HPP
@@ -0,0 +1,104 @@
+#ifndef VE281P4_ORDERING_HPP
+#define VE281P4_ORDERING_HPP
+
+#include <vector>
+#include <algorithm>
+#include "graph.hpp"
+
+/**
+ * Vertex orderings for cache locality: each returns the vertices in their new order, order[i] = old id of new id i
+ * BFS and RCM work on the undirected version of the graph, so that vertices adjacent in either direction
+ * get close ids
+ */
+namespace VertexOrder {
+    /**
+     * @return the graph with every arc in both directions
+     */
+    inline CSRGraph undirected(const CSRGraph &g) {
+        std::vector<Edge> edges = g.edges();
+        size_t m = edges.size();
+        edges.reserve(2 * m);
+        for (size_t i = 0; i < m; i++) edges.push_back({edges[i].v, edges[i].u, edges[i].w});
+        return CSRGraph(g.n, std::move(edges));
+    }
+
+    /**
+     * Breadth-first search from `root`, appending the vertices it reaches to order
+     * @param byDegree visit the neighbours of a vertex in increasing degree (Cuthill-McKee)
+     */
+    inline void bfs(const CSRGraph &u, ui root, bool byDegree, std::vector<char> &seen, std::vector<ui> &order) {
+        size_t head = order.size();
+        order.push_back(root);
+        seen[root] = 1;
+        while (head < order.size()) {
+            ui x = order[head++];
+            size_t first = order.size();
+            for (ui i = u.offset[x]; i < u.offset[x + 1]; i++) {
+                ui y = u.to[i];
+                if (seen[y]) continue;
+                seen[y] = 1;
+                order.push_back(y);
+            }
+            if (byDegree)
+                std::stable_sort(order.begin() + first, order.end(),
+                                 [&u](ui a, ui b) { return u.degree(a) < u.degree(b); });
+        }
+    }
+
+    /**
+     * BFS order, every connected component from its lowest id
+     * Time Complexity: O(n + m)
+     */
+    inline std::vector<ui> bfs(const CSRGraph &g) {
+        CSRGraph u = undirected(g);
+        std::vector<char> seen(g.n, 0);
+        std::vector<ui> order;
+        order.reserve(g.n);
+        for (ui v = 0; v < g.n; v++)
+            if (!seen[v]) bfs(u, v, false, seen, order);
+        return order;
+    }
+
+    /**
+     * Reverse Cuthill-McKee: a degree-ordered BFS from a pseudo-peripheral vertex of every connected component,
+     * reversed; this keeps the bandwidth of the adjacency matrix small
+     * Time Complexity: O(n + m log d)
+     */
+    inline std::vector<ui> reverseCuthillMcKee(const CSRGraph &g) {
+        CSRGraph u = undirected(g);
+        std::vector<char> seen(g.n, 0), probe(g.n, 0);
+        std::vector<ui> order, level;
+        order.reserve(g.n);
+        for (ui v = 0; v < g.n; v++) {
+            if (seen[v]) continue;
+            // pseudo-peripheral root: a few sweeps to the last vertex of a BFS, of minimum degree among ties
+            ui root = v;
+            for (int sweep = 0; sweep < 2; sweep++) {
+                level.clear();
+                bfs(u, root, true, probe, level);
+                for (ui x : level) probe[x] = 0;
+                root = level.back();
+            }
+            bfs(u, root, true, seen, order);
+        }
+        std::reverse(order.begin(), order.end());
+        return order;
+    }
+
+    /**
+     * Vertices by decreasing total (in + out) degree, so that hubs share cache lines
+     * Time Complexity: O(n log n + m)
+     */
+    inline std::vector<ui> degree(const CSRGraph &g) {
+        std::vector<ui> total(g.n, 0), order(g.n);
+        for (ui v = 0; v < g.n; v++) {
+            total[v] += g.degree(v);
+            for (ui i = g.offset[v]; i < g.offset[v + 1]; i++) ++total[g.to[i]];
+            order[v] = v;
+        }
+        std::stable_sort(order.begin(), order.end(), [&total](ui a, ui b) { return total[a] > total[b]; });
+        return order;
+    }
+}
+
+#endif //VE281P4_ORDERING_HPP
@@ -0,0 +1,271 @@
+// Long-running query server for ShortestP2P
+//
+// Usage: server <graph file> [fw|minplus|ch|alt|auto] [threads] [unix socket path]
+//
+// The graph (text or binary edge list) is loaded once. Queries are "A B" lines, read in large batches
+// from stdin, or from every client of the unix socket in turn; a negative A ends the session.
+// Each batch is answered in parallel on a work-stealing scheduler, one workspace per worker, and the answers ("dist" or "INF",
+// one line per query, in order) go through a buffered writer.
+// At the end of every session, QPS and p50 / p99 query latency are reported on stderr.
+// Dense matrices ask for transparent huge pages, interleaved over the NUMA nodes when serving on several threads.
+
+#include "shortestP2P.hpp"
+#include "../common/scheduler.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * Buffered writer over a file descriptor
+ */
+class BufferedWriter {
+public:
+    explicit BufferedWriter(int fd) : fd(fd), buffer(1 << 16) {}
+
+    ~BufferedWriter() { flush(); }
+
+    void write(long long x) {
+        if (buffer.size() - size < 24) flush();
+        auto res = std::to_chars(buffer.data() + size, buffer.data() + buffer.size(), x);
+        size = res.ptr - buffer.data();
+        buffer[size++] = '\n';
+    }
+
+    void write(const char *s) {
+        size_t len = std::strlen(s);
+        if (buffer.size() - size < len) flush();
+        std::memcpy(buffer.data() + size, s, len);
+        size += len;
+    }
+
+    bool flush() {
+        size_t done = 0;
+        while (done < size) {
+            ssize_t k = ::write(fd, buffer.data() + done, size - done);
+            if (k <= 0) {
+                size = 0;
+                return false;
+            }
+            done += static_cast<size_t>(k);
+        }
+        size = 0;
+        return true;
+    }
+
+private:
+    int fd;
+    std::vector<char> buffer;
+    size_t size = 0;
+};
+
+struct Query {
+    long long A, B;
+};
+
+/**
+ * Parse every complete line of buf[0, len), return the number of bytes consumed
+ * @param final parse a trailing line without newline too
+ */
+size_t parseQueries(const char *buf, size_t len, bool final, std::vector<Query> &queries) {
+    size_t end = len;
+    if (!final) {
+        while (end > 0 && buf[end - 1] != '\n') end--;
+    }
+    const char *p = buf, *last = buf + end;
+    while (p < last) {
+        while (p < last && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) p++;
+        if (p == last) break;
+        Query q{0, 0};
+        auto res = std::from_chars(p, last, q.A);
+        if (res.ec != std::errc()) {
+            // skip a malformed line
+            while (p < last && *p != '\n') p++;
+            continue;
+        }
+        p = res.ptr;
+        if (q.A < 0) {
+            queries.push_back(q);
+            return end;
+        }
+        while (p < last && (*p == ' ' || *p == '\t')) p++;
+        res = std::from_chars(p, last, q.B);
+        if (res.ec == std::errc()) queries.push_back(q);
+        p = res.ptr;
+        while (p < last && *p != '\n') p++;
+    }
+    return end;
+}
+
+class Server {
+public:
+    Server(ShortestP2P &sp, ui n, unsigned threads) : sp(sp), n(n), threads(std::max(1u, threads)),
+                                                       scheduler(this->threads) {
+        for (unsigned t = 0; t < this->threads; t++) workspaces.push_back(sp.workspace());
+    }
+
+    /**
+     * Answer queries from in until EOF or a negative A, writing to out
+     */
+    void session(int in, int out) {
+        BufferedWriter writer(out);
+        std::vector<char> buffer(1 << 20);
+        std::vector<Query> batch;
+        std::vector<long long> answers;
+        std::vector<double> latency;
+        size_t have = 0;
+        double busy = 0;
+        bool done = false;
+        while (!done) {
+            if (have == buffer.size()) buffer.resize(buffer.size() * 2);
+            ssize_t k = ::read(in, buffer.data() + have, buffer.size() - have);
+            bool eof = k <= 0;
+            if (!eof) have += static_cast<size_t>(k);
+            batch.clear();
+            size_t used = parseQueries(buffer.data(), have, eof, batch);
+            std::memmove(buffer.data(), buffer.data() + used, have - used);
+            have -= used;
+            if (!batch.empty() && batch.back().A < 0) {
+                batch.pop_back();
+                done = true;
+            }
+            done = done || eof;
+            if (batch.empty()) continue;
+
+            auto start = Clock::now();
+            answer(batch, answers, latency);
+            busy += std::chrono::duration<double>(Clock::now() - start).count();
+            for (long long d : answers) {
+                if (d == INF) writer.write("INF\n");
+                else writer.write(d);
+            }
+            if (!writer.flush()) break;
+        }
+        report(latency, busy);
+    }
+
+private:
+    // batches smaller than this are answered on the calling thread
+    static constexpr size_t PARALLEL_THRESHOLD = 4096;
+
+    ShortestP2P &sp;
+    ui n;
+    unsigned threads;
+    Parallel::Scheduler scheduler;
+    std::vector<ShortestP2P::Workspace> workspaces;     // one per worker
+
+    void answerRange(const std::vector<Query> &batch, size_t first, size_t last, ShortestP2P::Workspace &ws,
+                     std::vector<long long> &answers, std::vector<double> &latency) {
+        for (size_t i = first; i < last; i++) {
+            auto start = Clock::now();
+            const Query &q = batch[i];
+            if (q.A >= n || q.B < 0 || q.B >= n) answers[i] = INF;
+            else answers[i] = sp.query(static_cast<ui>(q.A), static_cast<ui>(q.B), ws);
+            latency[i] = std::chrono::duration<double>(Clock::now() - start).count();
+        }
+    }
+
+    void answer(const std::vector<Query> &batch, std::vector<long long> &answers,
+                std::vector<double> &latency) {
+        size_t offset = latency.size();
+        answers.assign(batch.size(), 0);
+        std::vector<double> batchLatency(batch.size());
+        if (threads == 1 || batch.size() < PARALLEL_THRESHOLD) {
+            answerRange(batch, 0, batch.size(), workspaces[0], answers, batchLatency);
+        }
+        else {
+            // a few chunks per worker, so that stealing evens out batches of slow queries
+            size_t grain = std::max<size_t>(256, batch.size() / (4 * threads));
+            Parallel::forRange<size_t>(0, batch.size(), grain, [&](size_t first, size_t last) {
+                answerRange(batch, first, last, workspaces[Parallel::Scheduler::workerIndex()], answers, batchLatency);
+            }, scheduler);
+        }
+        latency.resize(offset + batch.size());
+        std::copy(batchLatency.begin(), batchLatency.end(), latency.begin() + offset);
+    }
+
+    static void report(std::vector<double> &latency, double busy) {
+        if (latency.empty()) return;
+        auto percentile = [&latency](double p) {
+            size_t k = std::min(latency.size() - 1, static_cast<size_t>(p * latency.size()));
+            std::nth_element(latency.begin(), latency.begin() + k, latency.end());
+            return latency[k] * 1e6;
+        };
+        double p50 = percentile(0.50), p99 = percentile(0.99);
+        std::fprintf(stderr, "queries: %zu, busy: %.3f s, QPS: %.0f, p50: %.2f us, p99: %.2f us\n",
+                     latency.size(), busy, busy > 0 ? latency.size() / busy : 0.0, p50, p99);
+    }
+};
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <graph file> [fw|minplus|ch|alt|auto] [threads] [unix socket path]\n", argv[0]);
+        return 1;
+    }
+    std::string engineName = argc > 2 ? argv[2] : "fw";
+    ShortestP2P::Engine engine = ShortestP2P::Engine::FloydWarshall;
+    if (engineName == "ch") engine = ShortestP2P::Engine::ContractionHierarchy;
+    else if (engineName == "alt") engine = ShortestP2P::Engine::Landmark;
+    else if (engineName == "minplus") engine = ShortestP2P::Engine::MinPlus;
+    else if (engineName == "auto") engine = ShortestP2P::Engine::Auto;
+    else if (engineName != "fw") {
+        std::fprintf(stderr, "unknown engine %s\n", engineName.c_str());
+        return 1;
+    }
+    unsigned threads = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : std::thread::hardware_concurrency();
+
+    ShortestP2P sp(engine);
+    LargePages::Policy pages;
+    pages.pages = LargePages::Pages::Transparent;
+    pages.interleave = threads > 1;
+    sp.setPagePolicy(pages);
+    auto start = Clock::now();
+    sp.readGraph(argv[1]);
+    std::fprintf(stderr, "loaded %s in %.3f s\n", argv[1],
+                 std::chrono::duration<double>(Clock::now() - start).count());
+    static const char *const ENGINE_NAMES[] = {"fw", "ch", "alt", "minplus"};
+    ShortestP2P::MemoryReport memory = sp.memoryReport();
+    std::fprintf(stderr, "engine: %s, memory: estimated %.1f MiB, resident %.1f MiB, peak %.1f MiB, budget %.1f MiB\n",
+                 ENGINE_NAMES[static_cast<int>(sp.selectedEngine())], memory.estimated / 1048576.0,
+                 memory.resident / 1048576.0, memory.peak / 1048576.0, memory.budget / 1048576.0);
+    if (sp.selectedEngine() == ShortestP2P::Engine::Landmark)
+        std::fprintf(stderr, "landmarks: %u\n", memory.landmarks);
+    Server server(sp, sp.vertexCount(), threads);
+
+    if (argc <= 4) {
+        server.session(STDIN_FILENO, STDOUT_FILENO);
+        return 0;
+    }
+
+    std::signal(SIGPIPE, SIG_IGN);
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (listener < 0 || std::strlen(argv[4]) >= sizeof(addr.sun_path)) {
+        std::perror("socket");
+        return 1;
+    }
+    std::strcpy(addr.sun_path, argv[4]);
+    unlink(argv[4]);
+    if (bind(listener, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || listen(listener, 16) != 0) {
+        std::perror("bind");
+        return 1;
+    }
+    while (true) {
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0) continue;
+        server.session(client, client);
+        close(client);
+    }
+}
@@ -1,23 +1,40 @@
 #include<iostream>
-#include<list>
 #include<vector>
 #include<climits>
-// You are not allowed to include additional libraries, either in shortestP2P.hpp or shortestP2P.cc
+#include<cstdlib>
+#include<cstdint>
+#include<stdexcept>
+#include<type_traits>
 
 #define INF INT_MAX
 typedef unsigned int ui;
 
+#include "graph.hpp"
+#include "ch.hpp"
+#include "alt.hpp"
+#include "matrix.hpp"
+#include "minplus.hpp"
+#include "apsp_store.hpp"
+#include "loader.hpp"
+#include "ordering.hpp"
+#include "memory.hpp"
+
 using namespace std;
 
 
 
 class ShortestP2P {
   public:
-      ShortestP2P() {}
-      ~ShortestP2P() {
-          for (ui i = 0; i < n; i++) delete [] dis[i];
-          delete [] dis;
-      }
+      /* FloydWarshall: dense all-pairs matrix, O(n^3) preprocessing, O(1) query
+       * MinPlus: the same matrix by repeated min-plus squaring, O(n^3 log n) preprocessing in a GEMM-style SIMD kernel
+       * ContractionHierarchy: Johnson reweighting + CH, near-linear preprocessing, bidirectional upward query
+       * Landmark: Johnson reweighting + ALT, O(Ln) memory, A* query and O(L) distance bounds
+       * Auto: chosen by readGraph from the memory budget, see setMemoryBudget
+       */
+      enum class Engine { FloydWarshall, ContractionHierarchy, Landmark, MinPlus, Auto };
+
+      explicit ShortestP2P(Engine engine = Engine::FloydWarshall) : engine(engine), requested(engine) {}
+      ~ShortestP2P() {}
 
       /* Read the graph from stdin
        * The input has the following format:
@@ -46,6 +63,10 @@ class ShortestP2P {
        */
       void readGraph();
 
+      /* Read the graph from a file, in the text format above or the binary edge-list format of loader.hpp.
+       */
+      void readGraph(const std::string &path);
+
       /* Input: 2 vertices A and B
        * Output: distance between them.
        * cout << dist << endl;
@@ -55,96 +76,647 @@ class ShortestP2P {
        */
       void distance(unsigned int A, unsigned int B);
 
+      /* Input: 2 vertices A and B
+       * Output: distance between them, or INF when they are not connected.
+       */
+      long long query(ui A, ui B);
+
+      /* Query scratch of the sparse engines, one per thread.
+       */
+      struct Workspace {
+          ContractionHierarchy::Workspace ch;
+          LandmarkOracle::Workspace alt;
+      };
+
+      Workspace workspace() const;
+
+      /* Same as query(A, B), through a caller-owned workspace: queries with distinct workspaces
+       * may run concurrently with each other (but not with readGraph / updateEdge).
+       */
+      long long query(ui A, ui B, Workspace &ws) const;
+
+      /* Preprocessing time and memory of the contraction hierarchy.
+       * Only meaningful with Engine::ContractionHierarchy.
+       */
+      const ContractionHierarchy::Stats &chStats() const { return ch.getStats(); }
+
+      /* Number of landmarks and selection heuristic of the Landmark engine, call before readGraph.
+       */
+      void setLandmarks(ui L, LandmarkOracle::Selection selection = LandmarkOracle::Selection::Avoid) {
+          landmarkCount = L;
+          landmarkSelection = selection;
+      }
+
+      /* Memory budget of readGraph in bytes, 0 (the default) for the physical memory of the machine.
+       * readGraph estimates the footprint of the engine before building it, and throws std::runtime_error
+       * instead of running out of memory when it does not fit. Engine::Auto takes the first engine that fits:
+       * FloydWarshall (only up to DENSE_LIMIT vertices, beyond that O(n^3) is too slow anyway),
+       * then ContractionHierarchy, then Landmark with the most landmarks that fit, up to setLandmarks;
+       * the configured count is kept for later graphs, memoryReport tells how many were built.
+       */
+      void setMemoryBudget(size_t bytes) { memoryBudget = bytes; }
+
+      /* Page policy of the dense matrices, call before readGraph.
+       * Transparent or explicit huge pages cut the TLB misses of the random row accesses of large matrices,
+       * interleaving spreads them over the memory controllers of every NUMA node for multithreaded batches.
+       */
+      void setPagePolicy(const LargePages::Policy &policy) {
+          dis32.setPagePolicy(policy);
+          dis64.setPagePolicy(policy);
+          next16.setPagePolicy(policy);
+          next32.setPagePolicy(policy);
+      }
+
+      static constexpr ui DENSE_LIMIT = 8192;
+
+      /* Estimated peak bytes of readGraph with an engine, for n vertices, m edges of absolute weight at most maxAbs.
+       * Dense engines are exact up to allocator overhead, CH assumes a typical number of shortcuts.
+       */
+      static size_t estimateBytes(Engine engine, ui n, size_t m, long long maxAbs, bool paths = false,
+                                  ui landmarks = 16);
+
+      /* budget: the effective budget, estimated: the estimate of the selected engine,
+       * resident: bytes of the data structures held now, peak: peak resident set size of the process,
+       * landmarks: landmarks of the Landmark engine (0 with the others).
+       */
+      struct MemoryReport {
+          size_t budget, estimated, resident, peak;
+          ui landmarks;
+      };
+
+      MemoryReport memoryReport() const;
+
+      /* The engine in use, the choice of Engine::Auto after readGraph.
+       */
+      Engine selectedEngine() const { return engine; }
+
+      /* Vertex renumbering for cache locality, call before readGraph:
+       * Input keeps the input ids, BFS and RCM (reverse Cuthill-McKee) number neighbours close together,
+       * Degree puts high-degree vertices first. Ids are translated in every query, input and output.
+       */
+      enum class Ordering { Input, BFS, RCM, Degree };
+
+      void setOrdering(Ordering order) { ordering = order; }
+
+      /* Input: 2 vertices A and B
+       * Output: a lower and an upper bound of their distance in O(L), INF when unknown / unreachable.
+       * Only meaningful with Engine::Landmark.
+       */
+      std::pair<long long, long long> distanceBounds(ui A, ui B) const;
+
+      const LandmarkOracle::Stats &altStats() const { return alt.getStats(); }
+
+      /* Number of vertices of the current graph.
+       */
+      ui vertexCount() const { return n; }
+
+      /* Bytes of the Floyd-Warshall distance matrix, 4n^2 when int32 distances suffice and 8n^2 otherwise.
+       */
+      size_t matrixBytes() const { return compact ? dis32.bytes() : dis64.bytes(); }
+
+      /* Persist all-pairs distances in the APSPStore format, so that other processes can answer
+       * queries by mapping the file (see apsp_store.hpp) instead of recomputing.
+       */
+      void saveDistances(const std::string &path, bool compress = true);
+
+      /* Input: a hop limit k
+       * Output: the n x n matrix of shortest distances over walks of at most k arcs (INF_VALUE when there is none),
+       * by binary exponentiation with the min-plus kernel, O(n^3 log k). Works with every engine.
+       */
+      DistanceMatrix<long long> hopBoundedDistances(ui hops) const;
+
+      /* Input: an arc A -> B and its new weight (replacing all parallel arcs), the arc is added if absent.
+       * Output: whether the update was applied; it is rejected, leaving the graph unchanged,
+       * when it would create a negative cycle.
+       *
+       * FloydWarshall / MinPlus: a decrease is a single O(n^2) relaxation through the arc, an increase recomputes
+       * only the sources whose shortest path tree used the arc, by Dijkstra over Johnson potentials.
+       * Sparse engines are rebuilt from the updated graph.
+       */
+      bool updateEdge(ui A, ui B, int w);
+
+      /* Keep a next-hop matrix in the FloydWarshall engine (uint16 when n < 65535, uint32 otherwise),
+       * call before readGraph. The sparse engines always keep predecessors, MinPlus does not support paths.
+       */
+      void trackPaths(bool enable) { paths = enable; }
+
+      /* Input: 2 vertices A and B
+       * Output: the vertices of a shortest path from A to B, empty when they are not connected.
+       * O(path length) for FloydWarshall, one query plus O(path length) for the sparse engines.
+       * Throws std::logic_error for FloydWarshall without trackPaths(true), and for MinPlus.
+       */
+      std::vector<ui> path(ui A, ui B);
+
 
   private:
     // internal data and functions.
 
-      ui n;
-    //   std::vector<std::vector<std::pair<ui, int> > > e;
-    //   std::vector<std::vector<long long> > dis;
-      long long **dis;
-      bool valid;
+      Engine engine;
+      Engine requested;
+      size_t memoryBudget = 0;
+      size_t estimated = 0;
+      ui n = 0;
+      // dense all-pairs distances, int32 when the weight bounds allow it
+      DistanceMatrix<int> dis32;
+      DistanceMatrix<long long> dis64;
+      bool compact = 0;
+      bool valid = 0;
+      // dense next hops, INF_VALUE when unreachable
+      DistanceMatrix<uint16_t> next16;
+      DistanceMatrix<uint32_t> next32;
+      bool paths = 0;
+
+      // internal vertex ids list the strongly connected components in topological order, so a vertex only
+      // reaches ids in its own component or after it, and follow the chosen ordering inside a component;
+      // rank maps input ids to internal ids, vertexAt back
+      Ordering ordering = Ordering::Input;
+      std::vector<ui> rank, vertexAt;
+      // component of every internal vertex, numbered so that comp[B] > comp[A] proves B unreachable from A
+      std::vector<ui> comp;
+
+      // current graph and its Johnson potentials, sparse engines work on the reweighted graph
+      CSRGraph graph;
+      std::vector<long long> h;
+      ContractionHierarchy ch;
+      LandmarkOracle alt;
+      ui landmarkCount = 16;
+      // landmarks of the current graph, landmarkCount or fewer when Auto had to shrink them to the budget
+      ui effectiveLandmarks = 0;
+      LandmarkOracle::Selection landmarkSelection = LandmarkOracle::Selection::Avoid;
+      Workspace scratch;    // used by query(A, B)
 
-      long long spfa(ui S, ui T);
+      bool dense() const { return engine == Engine::FloydWarshall || engine == Engine::MinPlus; }
+      // call fn(dis, next) with the active distance matrix and next-hop matrix (nullptr without paths)
+      template<typename Fn>
+      void withDense(Fn fn);
+      template<typename Dist, typename Next>
+      void floydWarshall(DistanceMatrix<Dist> &dis, DistanceMatrix<Next> *next, const CSRGraph &g);
+      template<typename Dist>
+      void oneHop(DistanceMatrix<Dist> &dis, const CSRGraph &g) const;
+      template<typename Dist, typename Next>
+      void relaxThrough(DistanceMatrix<Dist> &dis, DistanceMatrix<Next> *next, ui A, ui B, long long w);
+      // switch the int32 matrix to int64 when an arc of absolute weight maxAbs breaks its bound
+      void widen(long long maxAbs);
+      template<typename Dist, typename Next>
+      void repairIncrease(DistanceMatrix<Dist> &dis, DistanceMatrix<Next> *next, ui A, ui B, long long old);
+      template<typename Next>
+      std::vector<ui> densePath(const DistanceMatrix<Next> &next, ui A, ui B) const;
+      long long internalQuery(ui A, ui B, Workspace &ws) const;
+      size_t effectiveBudget() const;
+      void selectEngine(size_t m, long long maxAbs);
+      void build(std::vector<Edge> edges);
+      void buildDense();
+      void buildSparse();
 
 
 };
 
 void ShortestP2P::readGraph() {
-    ui m;
-    std::cin >> n >> m;
-    // e.resize(n);
-    dis = new long long*[n]();
-    for (ui i = 0; i < n; i++) dis[i] = new long long[n]();
-    // dis.resize(n);
-    for (ui i = 0; i < n; i++) {
-        // dis[i].resize(n);
-        for (ui j = 0; j < n; j++) dis[i][j] = INF;
+    // parse straight from the stream buffer, std::cin stays usable for the queries that follow
+    std::vector<Edge> edges;
+    GraphLoader::StreambufSource src(std::cin.rdbuf());
+    GraphLoader::readText(src, n, edges);
+    build(std::move(edges));
+}
+
+void ShortestP2P::readGraph(const std::string &path) {
+    std::vector<Edge> edges;
+    GraphLoader::load(path, n, edges);
+    build(std::move(edges));
+}
+
+size_t ShortestP2P::estimateBytes(Engine engine, ui n, size_t m, long long maxAbs, bool paths, ui landmarks) {
+    const size_t N = n;
+    auto matrix = [N](size_t element) {
+        return N * ((N * element + DistanceMatrix<int>::ALIGNMENT - 1) / DistanceMatrix<int>::ALIGNMENT
+                    * DistanceMatrix<int>::ALIGNMENT);
+    };
+    const size_t graphBytes = (N + 1) * sizeof(ui) + m * (sizeof(ui) + sizeof(long long));
+    // the edge list with the sort buffer of the CSR construction, the graph, potentials, ids, components,
+    // and the scratch of the SCC pass and the ordering
+    size_t common = 3 * m * sizeof(Edge) + graphBytes + N * (sizeof(long long) + 8 * sizeof(ui));
+    switch (engine) {
+        case Engine::FloydWarshall: {
+            size_t dist = DistanceMatrix<int>::fits(n, maxAbs) ? sizeof(int) : sizeof(long long);
+            size_t next = !paths ? 0 : matrix(n < DistanceMatrix<uint16_t>::INF_VALUE ? sizeof(uint16_t)
+                                                                                     : sizeof(uint32_t));
+            return common + matrix(dist) + next;
+        }
+        case Engine::MinPlus:
+            // the matrix and its square
+            return common + 2 * matrix(DistanceMatrix<int>::fits(n, maxAbs) ? sizeof(int) : sizeof(long long));
+        case Engine::ContractionHierarchy:
+            // plus the reweighted copy of the graph
+            return common + graphBytes + ContractionHierarchy::estimateBytes(n, m);
+        case Engine::Landmark:
+            return common + graphBytes + LandmarkOracle::estimateBytes(n, m, landmarks);
+        default:
+            return common;
     }
-    for (ui i = 0; i < m; i++) {
-        ui u, v;
-        int w;
-        std::cin >> u >> v >> w;
-        if (w < dis[u][v]) dis[u][v] = w;
+}
+
+size_t ShortestP2P::effectiveBudget() const {
+    if (memoryBudget > 0) return memoryBudget;
+    size_t physical = Memory::physicalBytes();
+    return physical > 0 ? physical : SIZE_MAX;
+}
+
+void ShortestP2P::selectEngine(size_t m, long long maxAbs) {
+    const size_t budget = effectiveBudget();
+    auto fits = [&](Engine e, ui landmarks) {
+        estimated = estimateBytes(e, n, m, maxAbs, paths, landmarks);
+        return estimated <= budget;
+    };
+    effectiveLandmarks = landmarkCount;
+    if (requested != Engine::Auto) {
+        if (!fits(requested, landmarkCount))
+            throw std::runtime_error("the engine needs about " + std::to_string(estimated >> 20)
+                                     + " MiB, over the memory budget of " + std::to_string(budget >> 20) + " MiB");
+        engine = requested;
+        return;
     }
-    if (spfa(0, 1) == -INF) {
+    if (n <= DENSE_LIMIT && fits(Engine::FloydWarshall, landmarkCount))
+        engine = Engine::FloydWarshall;
+    else if (fits(Engine::ContractionHierarchy, landmarkCount))
+        engine = Engine::ContractionHierarchy;
+    else {
+        // halve the landmarks until they fit, ALT without any landmark is no engine to fall back to
+        ui landmarks = landmarkCount;
+        while (landmarks > 0 && !fits(Engine::Landmark, landmarks)) landmarks /= 2;
+        if (landmarks == 0)
+            throw std::runtime_error("no engine fits the memory budget of " + std::to_string(budget >> 20) + " MiB");
+        engine = Engine::Landmark;
+        effectiveLandmarks = landmarks;
+    }
+}
+
+ShortestP2P::MemoryReport ShortestP2P::memoryReport() const {
+    MemoryReport report;
+    report.budget = effectiveBudget();
+    report.estimated = estimated;
+    report.resident = graph.memoryUsage() + h.capacity() * sizeof(long long)
+                      + (rank.capacity() + vertexAt.capacity() + comp.capacity()) * sizeof(ui)
+                      + dis32.bytes() + dis64.bytes() + next16.bytes() + next32.bytes();
+    if (engine == Engine::ContractionHierarchy) report.resident += ch.getStats().bytes;
+    if (engine == Engine::Landmark) report.resident += alt.getStats().bytes;
+    report.peak = Memory::peakResidentBytes();
+    report.landmarks = engine == Engine::Landmark ? effectiveLandmarks : 0;
+    return report;
+}
+
+void ShortestP2P::build(std::vector<Edge> edges) {
+    long long maxAbs = 0;
+    for (auto &e : edges) maxAbs = std::max(maxAbs, e.w < 0 ? -e.w : e.w);
+    selectEngine(edges.size(), maxAbs);
+    graph = CSRGraph(n, std::move(edges));
+    ui count = stronglyConnectedComponents(graph, comp);
+    std::vector<ui> order;
+    if (ordering == Ordering::BFS) order = VertexOrder::bfs(graph);
+    else if (ordering == Ordering::RCM) order = VertexOrder::reverseCuthillMcKee(graph);
+    else if (ordering == Ordering::Degree) order = VertexOrder::degree(graph);
+    else {
+        order.resize(n);
+        for (ui v = 0; v < n; v++) order[v] = v;
+    }
+    // stable counting sort of the ordering by topological position of the component
+    std::vector<ui> start(count + 1, 0);
+    for (ui v = 0; v < n; v++) ++start[count - comp[v]];
+    for (ui c = 0; c < count; c++) start[c + 1] += start[c];
+    rank.resize(n);
+    vertexAt.resize(n);
+    for (ui v : order) {
+        rank[v] = start[count - 1 - comp[v]]++;
+        vertexAt[rank[v]] = v;
+    }
+    graph = graph.relabel(rank);
+    std::vector<ui> internal(n);
+    for (ui v = 0; v < n; v++) internal[rank[v]] = comp[v];
+    comp = std::move(internal);
+    if (!johnsonPotentials(graph, h)) {
         std::cout << "Invalid graph. Exiting." << std::endl;
         valid = 0;
         std::exit(0);
     }
+    if (dense())
+        buildDense();
+    else
+        buildSparse();
+    valid = 1;
+}
+
+void ShortestP2P::buildDense() {
+    // build has already ruled out negative cycles, so every finite distance stays within the weight bounds
+    long long maxAbs = 0;
+    for (long long w : graph.weight) maxAbs = std::max(maxAbs, w < 0 ? -w : w);
+    compact = DistanceMatrix<int>::fits(n, maxAbs);
+    if (engine == Engine::FloydWarshall) {
+        withDense([this](auto &dis, auto *next) { floydWarshall(dis, next, graph); });
+        return;
+    }
+    withDense([this](auto &dis, auto *) {
+        oneHop(dis, graph);
+        MinPlus::allPairs(dis);
+    });
+}
+
+template<typename Dist>
+void ShortestP2P::oneHop(DistanceMatrix<Dist> &dis, const CSRGraph &g) const {
+    dis.reset(n);
+    for (ui u = 0; u < n; u++) {
+        for (ui i = g.offset[u]; i < g.offset[u + 1]; i++) dis(u, g.to[i]) = static_cast<Dist>(g.weight[i]);
+        dis(u, u) = 0;
+    }
+}
+
+DistanceMatrix<long long> ShortestP2P::hopBoundedDistances(ui hops) const {
+    long long maxAbs = 0;
+    for (long long w : graph.weight) maxAbs = std::max(maxAbs, w < 0 ? -w : w);
+    DistanceMatrix<long long> result;
+    result.setPagePolicy(dis64.policy());
+    result.reset(n);
+    auto run = [&](auto &dis) {
+        typedef typename std::remove_reference<decltype(dis)>::type Matrix;
+        dis.setPagePolicy(dis64.policy());
+        oneHop(dis, graph);
+        MinPlus::hopBounded(dis, hops);
+        for (ui A = 0; A < n; A++)
+            for (ui B = 0; B < n; B++)
+                if (dis(rank[A], rank[B]) != Matrix::INF_VALUE) result(A, B) = dis(rank[A], rank[B]);
+    };
+    // a walk of at most k arcs is no shorter than a simple path when there is no negative cycle
+    if (DistanceMatrix<int>::fits(n, maxAbs)) {
+        DistanceMatrix<int> dis;
+        run(dis);
+    }
+    else {
+        DistanceMatrix<long long> dis;
+        run(dis);
+    }
+    return result;
+}
+
+template<typename Fn>
+void ShortestP2P::withDense(Fn fn) {
+    auto dispatch = [this, &fn](auto &dis) {
+        if (!paths || engine == Engine::MinPlus) fn(dis, static_cast<DistanceMatrix<uint16_t> *>(nullptr));
+        else if (n < DistanceMatrix<uint16_t>::INF_VALUE) fn(dis, &next16);
+        else fn(dis, &next32);
+    };
+    if (compact)
+        dispatch(dis32);
+    else
+        dispatch(dis64);
+}
+
+template<typename Dist, typename Next>
+void ShortestP2P::floydWarshall(DistanceMatrix<Dist> &dis, DistanceMatrix<Next> *next, const CSRGraph &g) {
+    const Dist inf = DistanceMatrix<Dist>::INF_VALUE;
+    const ui n = this->n;   // local copy: stores through int rows may alias the member
+    dis.reset(n);
+    if (next) next->reset(n);
+    for (ui u = 0; u < n; u++) {
+        Dist *row = dis.row(u);
+        for (ui i = g.offset[u]; i < g.offset[u + 1]; i++) {
+            row[g.to[i]] = static_cast<Dist>(g.weight[i]);
+            if (next) (*next)(u, g.to[i]) = static_cast<Next>(g.to[i]);
+        }
+        row[u] = 0;
+        if (next) (*next)(u, u) = static_cast<Next>(u);
+    }
+    // components are contiguous blocks of ids in topological order: only ids up to the end of k's block
+    // can reach k, and only ids from the start of k's block are reachable from k
+    std::vector<ui> blockBegin(n), blockEnd(n);
+    for (ui v = 0; v < n; v++) blockBegin[v] = v > 0 && comp[v] == comp[v - 1] ? blockBegin[v - 1] : v;
+    for (ui v = n; v-- > 0; ) blockEnd[v] = v + 1 < n && comp[v] == comp[v + 1] ? blockEnd[v + 1] : v + 1;
     for (ui k = 0; k < n; k++) {
-        for (ui i = 0; i < n; i++) {
-            for (ui j = 0; j < n; j++) {
-                if (dis[i][k] + dis[k][j] < dis[i][j]) {
-                    dis[i][j] = dis[i][k] + dis[k][j];
+        const Dist *rowK = dis.row(k);
+        const ui first = blockBegin[k], last = blockEnd[k];
+        for (ui i = 0; i < last; i++) {
+            Dist *rowI = dis.row(i);
+            const Dist dik = rowI[k];
+            if (dik == inf) continue;
+            // no overflow: both terms are finite and bounded by fits()
+            // branch-free select and unconditional store so that the loop vectorizes
+            if (next == nullptr) {
+                for (ui j = first; j < n; j++) {
+                    Dist t = rowK[j] == inf ? inf : static_cast<Dist>(dik + rowK[j]);
+                    rowI[j] = t < rowI[j] ? t : rowI[j];
                 }
+                continue;
+            }
+            Next *nextI = next->row(i);
+            const Next nik = nextI[k];
+            for (ui j = first; j < n; j++) {
+                Dist t = rowK[j] == inf ? inf : static_cast<Dist>(dik + rowK[j]);
+                bool better = t < rowI[j];
+                rowI[j] = better ? t : rowI[j];
+                nextI[j] = better ? nik : nextI[j];
             }
         }
     }
-    valid = 1;
 }
 
-void ShortestP2P::distance(ui A, ui B) {
-    if (!valid) return;
-    if (dis[A][B] == INF)
-        std::cout << "INF" << std::endl;
+void ShortestP2P::buildSparse() {
+    if (engine == Engine::ContractionHierarchy)
+        ch.build(reweight(graph, h));
     else
-        std::cout << dis[A][B] << std::endl;
+        alt.build(reweight(graph, h), effectiveLandmarks, landmarkSelection);
+    scratch = workspace();
+}
+
+bool ShortestP2P::updateEdge(ui A, ui B, int w) {
+    // internal ids from here on
+    A = rank[A];
+    B = rank[B];
+    size_t i = graph.arc(A, B);
+    long long old = i == graph.edgeCount() ? INF_DIST : graph.weight[i];
+    if (w == old) return true;
+    if (!dense() || A == B) {
+        CSRGraph previous = graph;
+        std::vector<Edge> edges = graph.edges();
+        if (i == graph.edgeCount()) edges.push_back({A, B, w});
+        else edges[i].w = w;
+        graph = CSRGraph(n, std::move(edges));
+        std::vector<long long> potentials;
+        if (!johnsonPotentials(graph, potentials)) {
+            graph = std::move(previous);
+            return false;
+        }
+        h = std::move(potentials);
+        stronglyConnectedComponents(graph, comp);
+        if (!dense()) buildSparse();
+        return true;
+    }
+
+    if (w < old) {
+        // the arc closes a negative cycle iff d(B, A) + w < 0
+        long long back = internalQuery(B, A, scratch);
+        if (back != INF && back + w < 0) return false;
+        if (i == graph.edgeCount()) {
+            std::vector<Edge> edges = graph.edges();
+            edges.push_back({A, B, w});
+            graph = CSRGraph(n, std::move(edges));
+            stronglyConnectedComponents(graph, comp);
+        }
+        else {
+            graph.weight[i] = w;
+        }
+        widen(w < 0 ? -static_cast<long long>(w) : w);
+        withDense([&](auto &dis, auto *next) { relaxThrough(dis, next, A, B, w); });
+        // h stays the exact virtual source distance: h'(x) = min(h(x), h(A) + w + d(B, x))
+        for (ui x = 0; x < n; x++) {
+            long long d = internalQuery(B, x, scratch);
+            if (d != INF) h[x] = std::min(h[x], h[A] + w + d);
+        }
+        return true;
+    }
+
+    // an increase keeps the potentials feasible and can not create a negative cycle
+    graph.weight[i] = w;
+    widen(w < 0 ? -static_cast<long long>(w) : w);
+    withDense([&](auto &dis, auto *next) { repairIncrease(dis, next, A, B, old); });
+    return true;
 }
 
-long long ShortestP2P::spfa(ui S, ui T) {
-    auto dis_ = new long long[n]();
-    auto flag = new bool[n]();
-    auto cnt = new ui[n]();
+void ShortestP2P::widen(long long maxAbs) {
+    if (!compact || DistanceMatrix<int>::fits(n, maxAbs)) return;
+    dis64.reset(n);
+    for (ui r = 0; r < n; r++)
+        for (ui c = 0; c < n; c++)
+            dis64(r, c) = dis32(r, c) == DistanceMatrix<int>::INF_VALUE
+                          ? DistanceMatrix<long long>::INF_VALUE : dis32(r, c);
+    dis32.reset(0);
+    compact = 0;
+}
+
+template<typename Dist, typename Next>
+void ShortestP2P::relaxThrough(DistanceMatrix<Dist> &dis, DistanceMatrix<Next> *next, ui A, ui B, long long w) {
+    const Dist inf = DistanceMatrix<Dist>::INF_VALUE;
+    const ui n = this->n;
+    // row B and column A are unchanged by the update (no negative cycle), so the relaxation is in place
+    const Dist *rowB = dis.row(B);
     for (ui i = 0; i < n; i++) {
-        dis_[i] = INF;
-        flag[i] = 0;
-        cnt[i] = 0;
-    }
-    dis_[S] = 0;
-    flag[S] = 1;
-    cnt[S] = 1;
-    std::list<ui> l;
-    l.push_back(S);
-    while (!l.empty()) {
-        auto u = l.front();
-        l.pop_front();
-        flag[u] = 0;
+        Dist *rowI = dis.row(i);
+        if (rowI[A] == inf) continue;
+        const long long base = rowI[A] + w;
+        // the first hop of i -> A -> B -> j
+        const Next hop = next ? (i == A ? static_cast<Next>(B) : (*next)(i, A)) : 0;
+        for (ui j = 0; j < n; j++) {
+            long long t = rowB[j] == inf ? inf : base + rowB[j];
+            if (t < rowI[j]) {
+                rowI[j] = static_cast<Dist>(t);
+                if (next) (*next)(i, j) = hop;
+            }
+        }
+    }
+}
+
+template<typename Dist, typename Next>
+void ShortestP2P::repairIncrease(DistanceMatrix<Dist> &dis, DistanceMatrix<Next> *next, ui A, ui B,
+                                 long long old) {
+    const Dist inf = DistanceMatrix<Dist>::INF_VALUE;
+    // a source can only lose a shortest path through A -> B if the arc was tight from it
+    std::vector<long long> d;
+    std::vector<ui> parent, order;
+    for (ui s = 0; s < n; s++) {
+        if (dis(s, A) == inf || dis(s, B) == inf || dis(s, B) != dis(s, A) + old) continue;
+        dijkstra(graph, h, s, d, next ? &parent : nullptr);
+        Dist *row = dis.row(s);
+        for (ui v = 0; v < n; v++) row[v] = d[v] == INF_DIST ? inf : static_cast<Dist>(d[v]);
+        if (next == nullptr) continue;
+        // first hops from the shortest path tree: hop(v) = v for children of s, hop(parent(v)) below
+        Next *hop = next->row(s);
+        for (ui v = 0; v < n; v++) hop[v] = DistanceMatrix<Next>::INF_VALUE;
+        hop[s] = static_cast<Next>(s);
         for (ui v = 0; v < n; v++) {
-            if (v == u) continue;
-            if (dis_[u] + dis[u][v] < dis_[v]) {
-                if (++cnt[v] >= n) return -INF;
-                dis_[v] = dis_[u] + dis[u][v];
-                if (!flag[v]) {
-                    l.push_back(v);
-                    flag[v] = 1;
-                }
+            if (d[v] == INF_DIST || hop[v] != DistanceMatrix<Next>::INF_VALUE) continue;
+            order.clear();
+            ui u = v;
+            while (hop[u] == DistanceMatrix<Next>::INF_VALUE && parent[u] != s) {
+                order.push_back(u);
+                u = parent[u];
             }
+            Next first = hop[u] != DistanceMatrix<Next>::INF_VALUE ? hop[u] : static_cast<Next>(u);
+            hop[u] = first;
+            for (ui x : order) hop[x] = first;
         }
     }
-    auto ans = dis_[T];
-    delete [] dis_;
-    delete [] flag;
-    delete [] cnt;
-    return ans;
-}
\ No newline at end of file
+}
+
+template<typename Next>
+std::vector<ui> ShortestP2P::densePath(const DistanceMatrix<Next> &next, ui A, ui B) const {
+    if (next(A, B) == DistanceMatrix<Next>::INF_VALUE) return {};
+    std::vector<ui> result{A};
+    // at most n vertices on a shortest path, the bound guards against zero-weight cycles
+    for (ui u = A; u != B && result.size() <= n; ) {
+        u = next(u, B);
+        result.push_back(u);
+    }
+    return result;
+}
+
+std::vector<ui> ShortestP2P::path(ui A, ui B) {
+    if (engine == Engine::MinPlus)
+        throw std::logic_error("the MinPlus engine does not keep next hops");
+    if (engine == Engine::FloydWarshall && !paths)
+        throw std::logic_error("path tracking is disabled, call trackPaths(true) before readGraph");
+    A = rank[A];
+    B = rank[B];
+    std::vector<ui> result;
+    if (engine == Engine::ContractionHierarchy) result = ch.path(A, B, scratch.ch);
+    else if (engine == Engine::Landmark) result = alt.path(A, B, scratch.alt);
+    else if (n < DistanceMatrix<uint16_t>::INF_VALUE) result = densePath(next16, A, B);
+    else result = densePath(next32, A, B);
+    for (ui &v : result) v = vertexAt[v];
+    return result;
+}
+
+long long ShortestP2P::query(ui A, ui B) {
+    return query(A, B, scratch);
+}
+
+ShortestP2P::Workspace ShortestP2P::workspace() const {
+    Workspace ws;
+    if (engine == Engine::ContractionHierarchy) ws.ch = ch.workspace();
+    if (engine == Engine::Landmark) ws.alt = alt.workspace();
+    return ws;
+}
+
+long long ShortestP2P::query(ui A, ui B, Workspace &ws) const {
+    return internalQuery(rank[A], rank[B], ws);
+}
+
+long long ShortestP2P::internalQuery(ui A, ui B, Workspace &ws) const {
+    if (dense()) {
+        if (compact) return dis32(A, B) == DistanceMatrix<int>::INF_VALUE ? INF : dis32(A, B);
+        return dis64(A, B) == DistanceMatrix<long long>::INF_VALUE ? INF : dis64(A, B);
+    }
+    // the condensation DAG rules out unreachable pairs without a search
+    if (comp[B] > comp[A]) return INF;
+    long long d = engine == Engine::ContractionHierarchy ? ch.query(A, B, ws.ch) : alt.query(A, B, ws.alt);
+    if (d == INF_DIST) return INF;
+    return d - h[A] + h[B];
+}
+
+std::pair<long long, long long> ShortestP2P::distanceBounds(ui A, ui B) const {
+    A = rank[A];
+    B = rank[B];
+    long long lo = alt.lowerBound(A, B), hi = alt.upperBound(A, B);
+    return {lo == INF_DIST ? INF : lo - h[A] + h[B], hi == INF_DIST ? INF : hi - h[A] + h[B]};
+}
+
+void ShortestP2P::saveDistances(const std::string &path, bool compress) {
+    APSPStore::write(path, n, [this](ui A, ui B) {
+        long long d = query(A, B);
+        return d == INF ? INF_DIST : d;
+    }, compress);
+}
+
+void ShortestP2P::distance(ui A, ui B) {
+    if (!valid) return;
+    long long d = query(A, B);
+    if (d == INF)
+        std::cout << "INF" << std::endl;
+    else
+        std::cout << d << std::endl;
+}
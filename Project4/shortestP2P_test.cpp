@@ -0,0 +1,334 @@
+// Tests of every engine against a brute-force Floyd-Warshall on random graphs with negative arcs: distances, paths,
+// weight updates, hop-bounded distances, and the graph loaders and distance store round trips
+//
+// Usage: shortestP2P_test
+
+#include "shortestP2P.hpp"
+#include "generators.hpp"
+#include "../common/check.hpp"
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+typedef ShortestP2P::Engine Engine;
+typedef std::vector<std::vector<long long>> Distances;
+
+static const std::string DIR = "/tmp/ve281_p4_test_" + std::to_string(getpid());
+
+static const std::pair<const char *, Engine> ENGINES[] = {
+        {"FloydWarshall", Engine::FloydWarshall},
+        {"ContractionHierarchy", Engine::ContractionHierarchy},
+        {"Landmark", Engine::Landmark},
+        {"MinPlus", Engine::MinPlus},
+        {"Auto", Engine::Auto},
+};
+
+static std::mt19937_64 rng(281);
+
+// all-pairs distances of the edge list, INF when unreachable; negative when the graph has a negative cycle
+static Distances bruteForce(ui n, const std::vector<Edge> &edges, bool *negativeCycle = nullptr) {
+    Distances d(n, std::vector<long long>(n, INF_DIST));
+    for (ui v = 0; v < n; v++) d[v][v] = 0;
+    for (const auto &e : edges) d[e.u][e.v] = std::min(d[e.u][e.v], e.w);
+    for (ui k = 0; k < n; k++)
+        for (ui i = 0; i < n; i++)
+            for (ui j = 0; j < n; j++)
+                if (d[i][k] != INF_DIST && d[k][j] != INF_DIST) d[i][j] = std::min(d[i][j], d[i][k] + d[k][j]);
+    bool cycle = false;
+    for (ui v = 0; v < n; v++) cycle |= d[v][v] < 0;
+    if (negativeCycle) *negativeCycle = cycle;
+    for (auto &row : d)
+        for (auto &x : row)
+            if (x == INF_DIST) x = INF;
+    return d;
+}
+
+// nonnegative random weights shifted by potentials: negative arcs, no negative cycle
+static std::vector<Edge> randomGraph(ui n, size_t m, uint64_t seed) {
+    std::vector<Edge> edges = GraphGen::random(n, m, 100, seed);
+    GraphGen::addPotentials(n, edges, 60, seed + 1);
+    return edges;
+}
+
+static std::string writeGraph(ui n, const std::vector<Edge> &edges) {
+    std::string path = DIR + "_graph.txt";
+    GraphLoader::saveText(path, n, edges);
+    return path;
+}
+
+static bool sameDistances(ShortestP2P &sp, const Distances &expected) {
+    ui n = static_cast<ui>(expected.size());
+    for (ui a = 0; a < n; a++)
+        for (ui b = 0; b < n; b++)
+            if (sp.query(a, b) != expected[a][b]) {
+                std::fprintf(stderr, "d(%u, %u) = %lld, expected %lld\n", a, b, sp.query(a, b), expected[a][b]);
+                return false;
+            }
+    return true;
+}
+
+// every path starts at A, ends at B, follows arcs and has the shortest length; empty exactly when unreachable
+static bool validPaths(ShortestP2P &sp, ui n, const std::vector<Edge> &edges, const Distances &expected) {
+    Distances arc = bruteForce(n, {});
+    for (const auto &e : edges)
+        if (e.u != e.v) arc[e.u][e.v] = arc[e.u][e.v] == INF ? e.w : std::min(arc[e.u][e.v], e.w);
+    for (ui a = 0; a < n; a++)
+        for (ui b = 0; b < n; b++) {
+            std::vector<ui> p = sp.path(a, b);
+            if (expected[a][b] == INF) {
+                if (!p.empty()) return false;
+                continue;
+            }
+            if (p.empty() || p.front() != a || p.back() != b) return false;
+            long long length = 0;
+            for (size_t k = 0; k + 1 < p.size(); k++) {
+                if (arc[p[k]][p[k + 1]] == INF) return false;
+                length += arc[p[k]][p[k + 1]];
+            }
+            if (length != expected[a][b]) {
+                std::fprintf(stderr, "path %u -> %u of length %lld, expected %lld\n", a, b, length, expected[a][b]);
+                return false;
+            }
+        }
+    return true;
+}
+
+static void load(ShortestP2P &sp, ui n, const std::vector<Edge> &edges) {
+    sp.trackPaths(true);
+    sp.setLandmarks(4);
+    sp.readGraph(writeGraph(n, edges));
+}
+
+static void test_engines() {
+    const struct { ui n; size_t m; } graphs[] = {{1, 0}, {2, 1}, {40, 200}, {90, 120}, {70, 2000}};
+    uint64_t seed = 1;
+    for (const auto &g : graphs) {
+        std::vector<Edge> edges = randomGraph(g.n, g.m, seed++);
+        Distances expected = bruteForce(g.n, edges);
+        for (const auto &engine : ENGINES) {
+            ShortestP2P sp(engine.second);
+            load(sp, g.n, edges);
+            bool ok = sameDistances(sp, expected);
+            if (engine.second != Engine::MinPlus) ok = validPaths(sp, g.n, edges, expected) && ok;
+            if (!ok) std::fprintf(stderr, "%s, n = %u, m = %zu\n", engine.first, g.n, g.m);
+            VE281_CHECK(ok);
+        }
+    }
+}
+
+static void test_orderings() {
+    const ui n = 60;
+    std::vector<Edge> edges = randomGraph(n, 240, 11);
+    Distances expected = bruteForce(n, edges);
+    for (auto ordering : {ShortestP2P::Ordering::BFS, ShortestP2P::Ordering::RCM, ShortestP2P::Ordering::Degree})
+        for (auto engine : {Engine::FloydWarshall, Engine::ContractionHierarchy}) {
+            ShortestP2P sp(engine);
+            sp.setOrdering(ordering);
+            load(sp, n, edges);
+            VE281_CHECK(sameDistances(sp, expected));
+            VE281_CHECK(validPaths(sp, n, edges, expected));
+        }
+}
+
+static void test_landmark_bounds() {
+    const ui n = 80;
+    std::vector<Edge> edges = randomGraph(n, 400, 21);
+    Distances expected = bruteForce(n, edges);
+    ShortestP2P sp(Engine::Landmark);
+    load(sp, n, edges);
+    bool bounded = true;
+    for (ui a = 0; a < n; a++)
+        for (ui b = 0; b < n; b++) {
+            auto bounds = sp.distanceBounds(a, b);
+            if (expected[a][b] == INF) continue;
+            bounded &= bounds.first <= expected[a][b];
+            bounded &= bounds.second == INF || expected[a][b] <= bounds.second;
+        }
+    VE281_CHECK(bounded);
+}
+
+// replace every parallel arc A -> B by one of weight w, as updateEdge does
+static std::vector<Edge> withArc(const std::vector<Edge> &edges, ui A, ui B, long long w) {
+    std::vector<Edge> result;
+    for (const auto &e : edges)
+        if (e.u != A || e.v != B) result.push_back(e);
+    result.push_back({A, B, w});
+    return result;
+}
+
+static void test_updates() {
+    const ui n = 30;
+    for (const auto &engine : ENGINES) {
+        std::vector<Edge> edges = randomGraph(n, 90, 31);
+        ShortestP2P sp(engine.second);
+        load(sp, n, edges);
+        std::uniform_int_distribution<ui> vertex(0, n - 1);
+        std::uniform_int_distribution<int> weight(-60, 150);
+        size_t rejected = 0;
+        for (int step = 0; step < 60; step++) {
+            ui A = vertex(rng), B = step % 10 == 0 ? A : vertex(rng);
+            // arcs already present half of the time, so that increases repair existing shortest paths
+            if (step % 2 == 0 && A != B && !edges.empty()) {
+                const Edge &e = edges[rng() % edges.size()];
+                A = e.u;
+                B = e.v;
+            }
+            // a negative self-loop is a negative cycle, the update must be rejected
+            int w = A == B ? -1 - static_cast<int>(rng() % 5) : weight(rng);
+            std::vector<Edge> updated = withArc(edges, A, B, w);
+            bool negativeCycle = false;
+            Distances expected = bruteForce(n, updated, &negativeCycle);
+            bool applied = sp.updateEdge(A, B, w);
+            VE281_CHECK(applied == !negativeCycle);
+            if (applied) edges = std::move(updated);
+            else rejected++;
+            // a rejected update leaves the distances unchanged
+            bool ok = sameDistances(sp, applied ? expected : bruteForce(n, edges));
+            if (!ok) std::fprintf(stderr, "%s, step %d: %u -> %u = %d\n", engine.first, step, A, B, w);
+            VE281_CHECK(ok);
+        }
+        VE281_CHECK(rejected > 0);
+        if (engine.second != Engine::MinPlus) VE281_CHECK(validPaths(sp, n, edges, bruteForce(n, edges)));
+    }
+}
+
+// increases past the int32 bound of the compact matrix, on the dense engines that keep it
+static void test_large_increase() {
+    // a random graph on the first 20 vertices, then a chain 19 -> 20 -> ... -> 23 that is the only way on
+    const ui n = 24;
+    std::vector<Edge> edges = randomGraph(20, 60, 71);
+    for (ui v = 19; v + 1 < n; v++) edges.push_back({v, v + 1, 3});
+    for (auto engine : {Engine::FloydWarshall, Engine::MinPlus}) {
+        ShortestP2P sp(engine);
+        load(sp, n, edges);
+        std::vector<Edge> current = edges;
+        for (ui v : {20, 21, 22}) {
+            const int w = 1500000000;
+            VE281_CHECK(sp.updateEdge(v, v + 1, w));
+            current = withArc(current, v, v + 1, w);
+            VE281_CHECK(sameDistances(sp, bruteForce(n, current)));
+        }
+        if (engine == Engine::FloydWarshall) VE281_CHECK(validPaths(sp, n, current, bruteForce(n, current)));
+        VE281_CHECK(sp.query(20, 23) == 4500000000LL);
+        VE281_CHECK(sp.matrixBytes() >= static_cast<size_t>(n) * n * sizeof(long long));
+    }
+}
+
+static void test_hop_bounded() {
+    const ui n = 25;
+    std::vector<Edge> edges = randomGraph(n, 80, 41);
+    ShortestP2P sp(Engine::ContractionHierarchy);
+    load(sp, n, edges);
+    DistanceMatrix<long long> walks = sp.hopBoundedDistances(n);
+    Distances expected = bruteForce(n, edges);
+    bool ok = true;
+    for (ui a = 0; a < n; a++)
+        for (ui b = 0; b < n; b++) {
+            long long d = walks(a, b) == DistanceMatrix<long long>::INF_VALUE ? INF : walks(a, b);
+            ok &= d == expected[a][b];
+        }
+    VE281_CHECK(ok);
+    // one hop: the lightest arc, 0 on the diagonal
+    DistanceMatrix<long long> arcs = sp.hopBoundedDistances(1);
+    Distances direct = bruteForce(n, {});
+    for (const auto &e : edges)
+        if (e.u != e.v) direct[e.u][e.v] = direct[e.u][e.v] == INF ? e.w : std::min(direct[e.u][e.v], e.w);
+    ok = true;
+    for (ui a = 0; a < n; a++)
+        for (ui b = 0; b < n; b++) {
+            long long d = arcs(a, b) == DistanceMatrix<long long>::INF_VALUE ? INF : arcs(a, b);
+            ok &= d == direct[a][b];
+        }
+    VE281_CHECK(ok);
+}
+
+static bool sameEdges(const std::vector<Edge> &a, const std::vector<Edge> &b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++)
+        if (a[i].u != b[i].u || a[i].v != b[i].v || a[i].w != b[i].w) return false;
+    return true;
+}
+
+static void test_loaders() {
+    const ui n = 500;
+    std::vector<Edge> edges = randomGraph(n, 5000, 51);
+    edges.push_back({0, n - 1, INT_MIN});
+    edges.push_back({n - 1, 0, INT_MAX});
+    const std::string text = DIR + "_graph.txt", binary = DIR + "_graph.bin";
+    ui loadedN = 0;
+    std::vector<Edge> loaded;
+    GraphLoader::saveText(text, n, edges);
+    GraphLoader::load(text, loadedN, loaded);
+    VE281_CHECK(loadedN == n && sameEdges(loaded, edges));
+    GraphLoader::saveBinary(binary, n, edges);
+    GraphLoader::load(binary, loadedN, loaded);
+    VE281_CHECK(loadedN == n && sameEdges(loaded, edges));
+    // no edges
+    GraphLoader::saveBinary(binary, 7, {});
+    GraphLoader::load(binary, loadedN, loaded);
+    VE281_CHECK(loadedN == 7 && loaded.empty());
+
+    // malformed input
+    auto writeText = [&](const char *content) {
+        FILE *file = std::fopen(text.c_str(), "w");
+        std::fputs(content, file);
+        std::fclose(file);
+    };
+    writeText("3\n2\n0 1 5\n");
+    VE281_CHECK_THROWS(GraphLoader::load(text, loadedN, loaded), std::runtime_error);
+    writeText("3\n1\n0 3 5\n");
+    VE281_CHECK_THROWS(GraphLoader::load(text, loadedN, loaded), std::runtime_error);
+    writeText("3\n1\n0 1 99999999999999999999\n");
+    VE281_CHECK_THROWS(GraphLoader::load(text, loadedN, loaded), std::runtime_error);
+    writeText("3\n-1\n");
+    VE281_CHECK_THROWS(GraphLoader::load(text, loadedN, loaded), std::runtime_error);
+    // a header that promises more edges than the file holds
+    writeText("3\n4000000000000\n0 1 5\n");
+    VE281_CHECK_THROWS(GraphLoader::load(text, loadedN, loaded), std::runtime_error);
+    VE281_CHECK_THROWS(GraphLoader::saveBinary(binary, 2, {{0, 1, 1LL << 40}}), std::runtime_error);
+    std::remove(text.c_str());
+    std::remove(binary.c_str());
+    VE281_CHECK_THROWS(GraphLoader::load(text, loadedN, loaded), std::runtime_error);
+}
+
+static void test_distance_store() {
+    const ui n = 150;
+    std::vector<Edge> edges = randomGraph(n, 300, 61);
+    Distances expected = bruteForce(n, edges);
+    ShortestP2P sp(Engine::FloydWarshall);
+    load(sp, n, edges);
+    const std::string path = DIR + "_apsp.bin";
+    for (bool compress : {true, false}) {
+        sp.saveDistances(path, compress);
+        APSPStore store;
+        store.open(path);
+        VE281_CHECK(store.size() == n);
+        bool ok = true;
+        for (ui a = 0; a < n; a++)
+            for (ui b = 0; b < n; b++)
+                ok &= store.distance(a, b) == (expected[a][b] == INF ? INF_DIST : expected[a][b]);
+        VE281_CHECK(ok);
+    }
+    FILE *file = std::fopen(path.c_str(), "wb");
+    std::fputs("not a distance store, but long enough to hold a header of sixty-four bytes", file);
+    std::fclose(file);
+    APSPStore store;
+    VE281_CHECK_THROWS(store.open(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+int main() {
+    Check::run("engines against Floyd-Warshall", test_engines);
+    Check::run("vertex orderings", test_orderings);
+    Check::run("landmark bounds", test_landmark_bounds);
+    Check::run("edge updates", test_updates);
+    Check::run("large weight increases", test_large_increase);
+    Check::run("hop-bounded distances", test_hop_bounded);
+    Check::run("graph loaders", test_loaders);
+    Check::run("distance store", test_distance_store);
+    std::remove((DIR + "_graph.txt").c_str());
+    return Check::report();
+}
@@ -0,0 +1,116 @@
+#ifndef VE281P4_SPFA_HPP
+#define VE281P4_SPFA_HPP
+
+#include <vector>
+#include "graph.hpp"
+
+/**
+ * Label-correcting shortest paths with negative weights over a CSRGraph
+ *
+ * Both functions take the initial labels in h: h[v] = 0 for every v is the virtual source of Johnson's algorithm,
+ * h[s] = 0 and INF_DIST elsewhere is a single source s. On success h holds the shortest distances.
+ */
+namespace LabelCorrecting {
+    struct Options {
+        bool smallLabelFirst = true;    // SLF: an entering vertex goes to the front if its label beats the front's
+        bool largeLabelLast = true;     // LLL: a front vertex above the queue's mean label is sent to the back
+    };
+
+    /**
+     * Plain Bellman-Ford: rounds over every arc until nothing changes
+     * Time Complexity: O(nm)
+     * @return false if a negative cycle is reachable from the initially labelled vertices
+     */
+    inline bool bellmanFord(const CSRGraph &g, std::vector<long long> &h, Stats *stats = nullptr) {
+        ui n = g.n;
+        for (ui round = 0; round <= n; round++) {
+            bool changed = false;
+            for (ui u = 0; u < n; u++) {
+                if (h[u] == INF_DIST) continue;
+                if (stats) ++stats->scans;
+                for (ui i = g.offset[u]; i < g.offset[u + 1]; i++) {
+                    ui v = g.to[i];
+                    if (h[u] + g.weight[i] < h[v]) {
+                        h[v] = h[u] + g.weight[i];
+                        changed = true;
+                        if (stats) ++stats->relaxations;
+                    }
+                }
+            }
+            if (!changed) return true;
+        }
+        // still relaxing after n rounds
+        return false;
+    }
+
+    /**
+     * SPFA (queue-based Bellman-Ford) with a fixed ring-buffer deque of n slots and optional SLF / LLL ordering
+     * Negative cycles are found early by looking for a cycle in the parent pointers once every n relaxations,
+     * which costs O(1) amortized per relaxation; a tentative path of n arcs is the termination guarantee
+     * Time Complexity: O(nm) worst case, usually close to linear
+     * @return false if a negative cycle is reachable from the initially labelled vertices
+     */
+    inline bool spfa(const CSRGraph &g, std::vector<long long> &h, Options options = Options(),
+                     Stats *stats = nullptr) {
+        ui n = g.n;
+        if (n == 0) return true;
+        std::vector<ui> queue(n), parent(n, n), len(n, 0), all(n);
+        for (ui v = 0; v < n; v++) all[v] = v;
+        ParentCycleCheck cycles(n);
+        std::vector<char> inQueue(n, 0);
+        ui head = 0, count = 0;
+        __int128 sum = 0;   // sum of the labels in the queue, for LLL
+        for (ui v = 0; v < n; v++) {
+            if (h[v] == INF_DIST) continue;
+            queue[count++] = v;
+            inQueue[v] = 1;
+            sum += h[v];
+        }
+        size_t untilCheck = n;
+        while (count > 0) {
+            if (options.largeLabelLast) {
+                // rotate at most count times, some vertex is never above the mean
+                for (ui k = 0; k < count && static_cast<__int128>(h[queue[head]]) * count > sum; k++) {
+                    ui u = queue[head];
+                    head = head + 1 == n ? 0 : head + 1;
+                    queue[head + count - 1 >= n ? head + count - 1 - n : head + count - 1] = u;
+                }
+            }
+            ui u = queue[head];
+            head = head + 1 == n ? 0 : head + 1;
+            --count;
+            inQueue[u] = 0;
+            sum -= h[u];
+            if (stats) ++stats->scans;
+            for (ui i = g.offset[u]; i < g.offset[u + 1]; i++) {
+                ui v = g.to[i];
+                long long d = h[u] + g.weight[i];
+                if (d >= h[v]) continue;
+                if (inQueue[v]) sum -= h[v] - d;
+                h[v] = d;
+                parent[v] = u;
+                len[v] = len[u] + 1;
+                if (stats) ++stats->relaxations;
+                if (len[v] >= n) return false;
+                if (--untilCheck == 0) {
+                    untilCheck = n;
+                    if (cycles.found(all.begin(), all.end(), parent)) return false;
+                }
+                if (inQueue[v]) continue;
+                inQueue[v] = 1;
+                sum += d;
+                if (options.smallLabelFirst && count > 0 && d < h[queue[head]]) {
+                    head = head == 0 ? n - 1 : head - 1;
+                    queue[head] = v;
+                }
+                else {
+                    queue[head + count >= n ? head + count - n : head + count] = v;
+                }
+                ++count;
+            }
+        }
+        return true;
+    }
+}
+
+#endif //VE281P4_SPFA_HPP
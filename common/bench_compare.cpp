@@ -0,0 +1,304 @@
+// Performance gate: compare two benchmark JSON files written by Bench::Runner::writeJson
+//
+// Usage: bench_compare <baseline json> <candidate json> [alpha] [min slowdown %]
+//
+// For every benchmark present in both files, prints the medians, the relative change of the median and the
+// p-values of one-sided Mann-Whitney U tests on the raw samples. A benchmark is SLOWER when the candidate
+// samples are significantly larger (p < alpha, default 0.05) and the median grew by at least the minimum
+// slowdown (default 2%), FASTER in the mirrored case. Benchmarks with a single sample on either side can not be
+// tested and only show the change. The exit status is 1 if any benchmark is SLOWER, 2 on bad input.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Minimal JSON value and recursive-descent parser, enough for the benchmark files
+ */
+struct Json {
+    enum Type { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT } type = NUL;
+    double number = 0;
+    std::string string;
+    std::vector<Json> array;
+    std::vector<std::pair<std::string, Json>> object;
+
+    const Json *find(const std::string &key) const {
+        for (auto &member : object)
+            if (member.first == key) return &member.second;
+        return nullptr;
+    }
+
+    static Json parse(const std::string &text) {
+        size_t pos = 0;
+        Json value = parseValue(text, pos);
+        skipSpace(text, pos);
+        if (pos != text.size()) fail(pos, "trailing characters");
+        return value;
+    }
+
+private:
+    [[noreturn]] static void fail(size_t pos, const char *what) {
+        throw std::runtime_error("JSON offset " + std::to_string(pos) + ": " + what);
+    }
+
+    static void skipSpace(const std::string &s, size_t &pos) {
+        while (pos < s.size() && (s[pos] == ' ' || s[pos] == '\n' || s[pos] == '\r' || s[pos] == '\t')) pos++;
+    }
+
+    static void expect(const std::string &s, size_t &pos, const char *word) {
+        for (const char *c = word; *c; c++, pos++)
+            if (pos >= s.size() || s[pos] != *c) fail(pos, "unexpected character");
+    }
+
+    static std::string parseString(const std::string &s, size_t &pos) {
+        expect(s, pos, "\"");
+        std::string out;
+        while (pos < s.size() && s[pos] != '"') {
+            char c = s[pos++];
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos >= s.size()) break;
+            char e = s[pos++];
+            if (e == 'n') out += '\n';
+            else if (e == 't') out += '\t';
+            else if (e == 'r') out += '\r';
+            else if (e == 'b') out += '\b';
+            else if (e == 'f') out += '\f';
+            else if (e == 'u') {
+                // code points below 0x80 are all the writer escapes
+                if (pos + 4 > s.size()) fail(pos, "bad escape");
+                unsigned code = static_cast<unsigned>(std::strtoul(s.substr(pos, 4).c_str(), nullptr, 16));
+                out += code < 0x80 ? static_cast<char>(code) : '?';
+                pos += 4;
+            }
+            else out += e;
+        }
+        expect(s, pos, "\"");
+        return out;
+    }
+
+    static Json parseValue(const std::string &s, size_t &pos) {
+        skipSpace(s, pos);
+        if (pos >= s.size()) fail(pos, "unexpected end");
+        Json v;
+        char c = s[pos];
+        if (c == '{') {
+            v.type = OBJECT;
+            pos++;
+            skipSpace(s, pos);
+            if (pos < s.size() && s[pos] == '}') {
+                pos++;
+                return v;
+            }
+            while (true) {
+                skipSpace(s, pos);
+                std::string key = parseString(s, pos);
+                skipSpace(s, pos);
+                expect(s, pos, ":");
+                v.object.emplace_back(std::move(key), parseValue(s, pos));
+                skipSpace(s, pos);
+                if (pos < s.size() && s[pos] == ',') pos++;
+                else break;
+            }
+            expect(s, pos, "}");
+        }
+        else if (c == '[') {
+            v.type = ARRAY;
+            pos++;
+            skipSpace(s, pos);
+            if (pos < s.size() && s[pos] == ']') {
+                pos++;
+                return v;
+            }
+            while (true) {
+                v.array.push_back(parseValue(s, pos));
+                skipSpace(s, pos);
+                if (pos < s.size() && s[pos] == ',') pos++;
+                else break;
+            }
+            expect(s, pos, "]");
+        }
+        else if (c == '"') {
+            v.type = STRING;
+            v.string = parseString(s, pos);
+        }
+        else if (c == 't') {
+            expect(s, pos, "true");
+            v.type = BOOL;
+            v.number = 1;
+        }
+        else if (c == 'f') {
+            expect(s, pos, "false");
+            v.type = BOOL;
+        }
+        else if (c == 'n') {
+            expect(s, pos, "null");
+        }
+        else {
+            char *end;
+            v.type = NUMBER;
+            v.number = std::strtod(s.c_str() + pos, &end);
+            if (end == s.c_str() + pos) fail(pos, "unexpected character");
+            pos = static_cast<size_t>(end - s.c_str());
+        }
+        return v;
+    }
+};
+
+/**
+ * One-sided Mann-Whitney U test of "b tends to be larger than a"
+ * Exact null distribution when there are no ties and both samples are small, otherwise the normal
+ * approximation with tie and continuity corrections
+ * Time Complexity: O(n1 n2 log(n1 n2)) approximate, O((n1 n2)^2) exact
+ * @return the p-value, 1 if either sample is empty
+ */
+double mannWhitneyGreater(const std::vector<double> &a, const std::vector<double> &b) {
+    static constexpr size_t EXACT_LIMIT = 50;
+    size_t n1 = a.size(), n2 = b.size();
+    if (n1 == 0 || n2 == 0) return 1;
+    // U = pairs (x in a, y in b) with y > x, ties count one half
+    std::vector<std::pair<double, int>> all;
+    for (double x : a) all.emplace_back(x, 0);
+    for (double y : b) all.emplace_back(y, 1);
+    std::sort(all.begin(), all.end());
+    size_t n = all.size();
+    double rankSumB = 0, tieTerm = 0;
+    bool ties = false;
+    for (size_t i = 0; i < n;) {
+        size_t j = i;
+        while (j < n && all[j].first == all[i].first) j++;
+        double rank = (static_cast<double>(i + 1) + static_cast<double>(j)) / 2, t = static_cast<double>(j - i);
+        for (size_t k = i; k < j; k++)
+            if (all[k].second) rankSumB += rank;
+        if (j - i > 1) {
+            ties = true;
+            tieTerm += t * t * t - t;
+        }
+        i = j;
+    }
+    double u = rankSumB - static_cast<double>(n2) * static_cast<double>(n2 + 1) / 2;
+
+    if (!ties && n1 <= EXACT_LIMIT && n2 <= EXACT_LIMIT) {
+        // count[j][k]: arrangements of j values of a and some of b with U = k, built one sample size at a time
+        size_t maxU = n1 * n2;
+        std::vector<std::vector<double>> previous(n1 + 1, std::vector<double>(maxU + 1, 0)), current = previous;
+        for (size_t i = 0; i <= n1; i++) previous[i][0] = 1;     // no b values
+        for (size_t m = 1; m <= n2; m++) {
+            for (size_t i = 0; i <= n1; i++) {
+                std::fill(current[i].begin(), current[i].end(), 0);
+                // the largest value is from b (adds i to U) or from a
+                for (size_t k = 0; k <= maxU; k++) {
+                    double c = k >= i ? previous[i][k - i] : 0;
+                    if (i > 0) c += current[i - 1][k];
+                    current[i][k] = c;
+                }
+            }
+            std::swap(previous, current);
+        }
+        const std::vector<double> &count = previous[n1];
+        double total = 0, tail = 0;
+        for (size_t k = 0; k <= maxU; k++) {
+            total += count[k];
+            if (static_cast<double>(k) >= u - 1e-9) tail += count[k];
+        }
+        return tail / total;
+    }
+    double mean = static_cast<double>(n1) * static_cast<double>(n2) / 2;
+    double variance = static_cast<double>(n1) * static_cast<double>(n2) / 12 *
+                      (static_cast<double>(n + 1) - tieTerm / (static_cast<double>(n) * static_cast<double>(n - 1)));
+    if (variance <= 0) return 1;
+    double z = (u - mean - 0.5) / std::sqrt(variance);
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+struct Benchmark {
+    double median = 0;
+    std::vector<double> samples;
+};
+
+std::map<std::string, Benchmark> load(const char *path, std::vector<std::string> &order) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error(std::string("can not read ") + path);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    Json root = Json::parse(buffer.str());
+    const Json *list = root.find("benchmarks");
+    if (!list || list->type != Json::ARRAY) throw std::runtime_error(std::string(path) + ": no benchmarks array");
+    std::map<std::string, Benchmark> result;
+    for (const Json &entry : list->array) {
+        const Json *name = entry.find("name"), *median = entry.find("median"), *samples = entry.find("samples");
+        if (!name || !median || !samples) throw std::runtime_error(std::string(path) + ": incomplete benchmark");
+        Benchmark b;
+        b.median = median->number;
+        for (const Json &x : samples->array) b.samples.push_back(x.number);
+        if (!result.count(name->string)) order.push_back(name->string);
+        result[name->string] = std::move(b);
+    }
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: %s <baseline json> <candidate json> [alpha] [min slowdown %%]\n", argv[0]);
+        return 2;
+    }
+    double alpha = argc > 3 ? std::atof(argv[3]) : 0.05;
+    double minChange = (argc > 4 ? std::atof(argv[4]) : 2.0) / 100;
+    std::map<std::string, Benchmark> baseline, candidate;
+    std::vector<std::string> order, candidateOrder;
+    try {
+        baseline = load(argv[1], order);
+        candidate = load(argv[2], candidateOrder);
+    }
+    catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 2;
+    }
+
+    std::printf("%-40s %12s %12s %9s %9s %9s  %s\n", "benchmark", "baseline", "candidate", "change", "p(slower)",
+                "p(faster)", "verdict");
+    size_t slower = 0, faster = 0, compared = 0;
+    for (const std::string &name : order) {
+        auto it = candidate.find(name);
+        if (it == candidate.end()) continue;
+        const Benchmark &a = baseline[name], &b = it->second;
+        compared++;
+        double change = a.median > 0 ? b.median / a.median - 1 : 0;
+        bool testable = a.samples.size() > 1 && b.samples.size() > 1;
+        const char *verdict = "";
+        char pSlower[16] = "-", pFaster[16] = "-";
+        if (testable) {
+            double up = mannWhitneyGreater(a.samples, b.samples), down = mannWhitneyGreater(b.samples, a.samples);
+            std::snprintf(pSlower, sizeof(pSlower), "%.4f", up);
+            std::snprintf(pFaster, sizeof(pFaster), "%.4f", down);
+            if (up < alpha && change >= minChange) {
+                verdict = "SLOWER";
+                slower++;
+            }
+            else if (down < alpha && -change >= minChange) {
+                verdict = "faster";
+                faster++;
+            }
+        }
+        else verdict = "(untested)";
+        std::printf("%-40s %12.6g %12.6g %+8.2f%% %9s %9s  %s\n", name.c_str(), a.median, b.median, change * 100,
+                    pSlower, pFaster, verdict);
+    }
+    for (const std::string &name : order)
+        if (!candidate.count(name)) std::printf("%-40s only in baseline\n", name.c_str());
+    for (const std::string &name : candidateOrder)
+        if (!baseline.count(name)) std::printf("%-40s only in candidate\n", name.c_str());
+    std::printf("\n%zu compared, %zu slower, %zu faster (alpha %g, min change %g%%)\n", compared, slower, faster,
+                alpha, minChange * 100);
+    return slower > 0 ? 1 : 0;
+}
@@ -0,0 +1,111 @@
+// TLB benchmark of LargePages: dependent and independent random loads over one large buffer per page policy
+//
+// Usage: bench_pages [MiB] [json file]
+//
+// The buffer is split into cache lines linked in one random cycle (Sattolo), the same cycle for every policy.
+// "chase" follows the cycle, so every load waits for the previous one and a TLB miss adds its full page walk;
+// "gather" issues independent loads at random lines. Each policy reports how much of its buffer the kernel
+// actually backed by huge pages, an explicit policy without reserved huge pages falls back to transparent ones.
+
+#include "large_pages.hpp"
+#include "benchmark.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static constexpr size_t LINE = 64 / sizeof(uint64_t);
+static constexpr size_t STEPS = 1 << 20;
+
+/**
+ * Bytes of the mapping containing p that are on huge pages, transparent or explicit, from /proc/self/smaps
+ */
+size_t hugeBytes(const void *p) {
+    std::ifstream in("/proc/self/smaps");
+    std::string line;
+    uintptr_t address = reinterpret_cast<uintptr_t>(p);
+    bool inside = false;
+    size_t kib = 0;
+    while (std::getline(in, line)) {
+        unsigned long long begin, end;
+        if (std::sscanf(line.c_str(), "%llx-%llx ", &begin, &end) == 2 && line.find(':') > line.find(' ')) {
+            if (inside) break;
+            inside = begin <= address && address < end;
+            continue;
+        }
+        if (!inside) continue;
+        std::istringstream fields(line);
+        std::string key;
+        size_t value = 0;
+        fields >> key >> value;
+        if (key == "AnonHugePages:" || key == "Private_Hugetlb:" || key == "Shared_Hugetlb:") kib += value;
+    }
+    return kib * 1024;
+}
+
+int main(int argc, char *argv[]) {
+    size_t mib = argc > 1 ? static_cast<size_t>(std::atol(argv[1])) : 512;
+    size_t bytes = mib << 20, lines = bytes / (LINE * sizeof(uint64_t));
+    if (lines < 2) {
+        std::fprintf(stderr, "buffer too small\n");
+        return 1;
+    }
+
+    // next[i]: the line after line i in a random cycle through all of them
+    std::vector<uint32_t> next(lines);
+    for (size_t i = 0; i < lines; i++) next[i] = static_cast<uint32_t>(i);
+    std::mt19937_64 rng(281);
+    for (size_t i = lines - 1; i > 0; i--)
+        std::swap(next[i], next[std::uniform_int_distribution<size_t>(0, i - 1)(rng)]);
+
+    struct Variant {
+        const char *name;
+        LargePages::Policy policy;
+    };
+    std::vector<Variant> variants = {{"4k", {LargePages::Pages::Default, false}},
+                                     {"transparent", {LargePages::Pages::Transparent, false}},
+                                     {"explicit", {LargePages::Pages::Explicit, false}}};
+    if (LargePages::Detail::multipleNodes())
+        variants.push_back({"transparent+interleave", {LargePages::Pages::Transparent, true}});
+
+    Bench::Runner runner;
+    runner.context("buffer_mib", std::to_string(mib));
+    for (const Variant &variant : variants) {
+        uint64_t *buffer = static_cast<uint64_t *>(LargePages::allocate(bytes, 64, variant.policy));
+        for (size_t i = 0; i < lines; i++) {
+            buffer[i * LINE] = next[i];
+            for (size_t k = 1; k < LINE; k++) buffer[i * LINE + k] = k;
+        }
+        size_t huge = hugeBytes(buffer);
+        std::printf("%s: %.1f of %zu MiB on huge pages\n", variant.name, static_cast<double>(huge) / 1048576, mib);
+        runner.context(std::string(variant.name) + ".huge_mib", std::to_string(huge >> 20));
+
+        uint64_t position = 0;
+        runner.run(std::string("chase/") + variant.name, [&]() {
+            for (size_t s = 0; s < STEPS; s++) position = buffer[position * LINE];
+            Bench::doNotOptimize(position);
+        });
+        uint64_t state = 88172645463325252ULL;
+        runner.run(std::string("gather/") + variant.name, [&]() {
+            uint64_t sum = 0;
+            for (size_t s = 0; s < STEPS; s++) {
+                state ^= state << 13;
+                state ^= state >> 7;
+                state ^= state << 17;
+                sum += buffer[state % lines * LINE + 1];
+            }
+            Bench::doNotOptimize(sum);
+        });
+        LargePages::deallocate(buffer, bytes);
+    }
+    if (argc > 2 && !runner.writeJson(argv[2])) {
+        std::fprintf(stderr, "can not write %s\n", argv[2]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,387 @@
+#ifndef VE281_BENCHMARK_HPP
+#define VE281_BENCHMARK_HPP
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <cstring>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+/**
+ * Micro-benchmark harness shared by the projects
+ *
+ * A benchmark is warmed up, then timed over several samples; the summary is robust to outliers (median,
+ * median absolute deviation, distribution-free confidence interval of the median). Hardware counters come from
+ * Linux perf_event when the kernel allows it. Results go to stdout as a table and optionally to a JSON file
+ * with every raw sample, for comparing runs across commits.
+ */
+namespace Bench {
+    /**
+     * Keep the compiler from discarding a value, or from assuming it did not change
+     */
+#if defined(__GNUC__)
+    template<typename T>
+    inline void doNotOptimize(const T &value) { asm volatile("" : : "r,m"(value) : "memory"); }
+
+    template<typename T>
+    inline void doNotOptimize(T &value) { asm volatile("" : "+r,m"(value) : : "memory"); }
+
+    /**
+     * Force pending writes to memory, so that stores are not optimized away
+     */
+    inline void clobberMemory() { asm volatile("" : : : "memory"); }
+#else
+    template<typename T>
+    inline void doNotOptimize(const T &value) {
+        static volatile const void *sink;
+        sink = &value;
+    }
+
+    inline void clobberMemory() {}
+#endif
+
+    /**
+     * Hardware counters of the calling thread through perf_event_open, as one group so that they cover the same
+     * instructions; counters the kernel refuses (perf_event_paranoid, virtual machines) are left out
+     */
+    class PerfCounters {
+    public:
+        enum Event { CYCLES, INSTRUCTIONS, LLC_MISSES, BRANCH_MISSES, DTLB_MISSES, EVENT_COUNT };
+
+        static const char *name(int event) {
+            static const char *const NAMES[EVENT_COUNT] = {"cycles", "instructions", "llc_misses", "branch_misses",
+                                                           "dtlb_misses"};
+            return NAMES[event];
+        }
+
+        PerfCounters() {
+            fds.fill(-1);
+#ifdef __linux__
+            // data TLB misses of loads are a generalized cache event: cache id, operation, result
+            const uint64_t dtlbReadMiss = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            const uint32_t types[EVENT_COUNT] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+                                                 PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE};
+            const uint64_t configs[EVENT_COUNT] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                   PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES,
+                                                   dtlbReadMiss};
+            for (int e = 0; e < EVENT_COUNT; e++) {
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = types[e];
+                attr.config = configs[e];
+                attr.disabled = leader < 0;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                                   PERF_FORMAT_TOTAL_TIME_RUNNING;
+                fds[e] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+                if (fds[e] >= 0 && leader < 0) leader = fds[e];
+                if (fds[e] >= 0) order.push_back(e);
+            }
+#endif
+        }
+
+        PerfCounters(const PerfCounters &) = delete;
+
+        PerfCounters &operator=(const PerfCounters &) = delete;
+
+        ~PerfCounters() {
+#ifdef __linux__
+            for (int fd : fds)
+                if (fd >= 0) close(fd);
+#endif
+        }
+
+        bool available() const { return leader >= 0; }
+
+        bool has(int event) const { return fds[event] >= 0; }
+
+        void start() {
+#ifdef __linux__
+            if (leader < 0) return;
+            ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+        }
+
+        /**
+         * Stop counting and store the counts since start, scaled up if the kernel multiplexed the group
+         * @return false if nothing was counted
+         */
+        bool stop(std::array<double, EVENT_COUNT> &counts) {
+            counts.fill(0);
+#ifdef __linux__
+            if (leader < 0) return false;
+            ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+            // nr, time enabled, time running, one value per counter
+            uint64_t buffer[3 + EVENT_COUNT];
+            ssize_t k = ::read(leader, buffer, sizeof(buffer));
+            if (k < static_cast<ssize_t>(3 * sizeof(uint64_t)) || buffer[2] == 0) return false;
+            double scale = static_cast<double>(buffer[1]) / static_cast<double>(buffer[2]);
+            for (size_t i = 0; i < buffer[0] && i < order.size(); i++)
+                counts[order[i]] = static_cast<double>(buffer[3 + i]) * scale;
+            return true;
+#else
+            return false;
+#endif
+        }
+
+    private:
+        std::array<int, EVENT_COUNT> fds;
+        std::vector<int> order;     // events in group read order
+        int leader = -1;
+    };
+
+    struct Options {
+        unsigned warmup = 1;                // untimed runs before the samples
+        unsigned samples = 10;              // timed samples
+        double minSampleSeconds = 1e-3;     // a fast benchmark repeats its body until one sample takes this long
+        bool print = true;                  // print a line per benchmark
+    };
+
+    /**
+     * Summary of the samples of one benchmark, all in seconds per iteration
+     * [low, high] is a distribution-free 95% confidence interval of the median, from order statistics
+     */
+    struct Summary {
+        double median = 0, mad = 0, mean = 0, stddev = 0, min = 0, max = 0, low = 0, high = 0;
+
+        static Summary of(std::vector<double> samples) {
+            Summary s;
+            size_t n = samples.size();
+            if (n == 0) return s;
+            std::sort(samples.begin(), samples.end());
+            auto median = [](const std::vector<double> &sorted) {
+                size_t n = sorted.size();
+                return n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+            };
+            s.median = median(samples);
+            s.min = samples.front();
+            s.max = samples.back();
+            for (double x : samples) s.mean += x;
+            s.mean /= static_cast<double>(n);
+            for (double x : samples) s.stddev += (x - s.mean) * (x - s.mean);
+            s.stddev = n > 1 ? std::sqrt(s.stddev / static_cast<double>(n - 1)) : 0;
+            std::vector<double> deviation(n);
+            for (size_t i = 0; i < n; i++) deviation[i] = std::fabs(samples[i] - s.median);
+            std::sort(deviation.begin(), deviation.end());
+            s.mad = median(deviation);
+            // ranks n / 2 -+ 1.96 sqrt(n) / 2 of the binomial(n, 1/2) normal approximation
+            double half = 0.98 * std::sqrt(static_cast<double>(n));
+            double k = std::floor(static_cast<double>(n) / 2 - half);
+            size_t lowRank = k < 0 ? 0 : static_cast<size_t>(k);
+            s.low = samples[lowRank];
+            s.high = samples[n - 1 - lowRank];
+            return s;
+        }
+    };
+
+    struct Result {
+        std::string name;
+        size_t iterations = 1;              // runs of the body per sample
+        std::vector<double> samples;        // seconds per iteration
+        Summary summary;
+        std::vector<std::pair<std::string, double>> counters;     // per iteration, median over the samples
+    };
+
+    /**
+     * Runs benchmarks, prints a line for each, and keeps the results for writeJson
+     */
+    class Runner {
+    public:
+        explicit Runner(Options options = Options()) : options(options) {
+            if (const char *commit = std::getenv("BENCH_COMMIT")) context("commit", commit);
+            char host[256] = "";
+#ifdef __linux__
+            gethostname(host, sizeof(host) - 1);
+#endif
+            context("host", host);
+#ifdef __VERSION__
+            context("compiler", __VERSION__);
+#endif
+            std::time_t now = std::time(nullptr);
+            char date[32];
+            std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+            context("date", date);
+            context("perf_counters", perf.available() ? "yes" : "no");
+        }
+
+        Options options;
+
+        /**
+         * Add a key to the context object of the JSON output, such as the input size or a configuration
+         */
+        void context(const std::string &key, const std::string &value) { contexts.emplace_back(key, value); }
+
+        /**
+         * Time fn(), repeated until a sample takes options.minSampleSeconds
+         */
+        template<typename F>
+        const Result &run(const std::string &name, F &&fn) {
+            size_t iterations = 1;
+            for (unsigned i = 0; i < options.warmup; i++) fn();
+            // calibrate: double the batch until it is long enough to time
+            while (true) {
+                auto start = Clock::now();
+                for (size_t i = 0; i < iterations; i++) fn();
+                double t = std::chrono::duration<double>(Clock::now() - start).count();
+                if (t >= options.minSampleSeconds || iterations >= (size_t(1) << 30)) break;
+                iterations = t <= 0 ? iterations * 16
+                                    : std::max(iterations * 2, static_cast<size_t>(
+                                            std::ceil(iterations * options.minSampleSeconds / t * 1.2)));
+            }
+            return measure(name, iterations, []() {}, fn);
+        }
+
+        /**
+         * Time fn() once per sample after an untimed setup(), for benchmarks that consume their input (sorting)
+         */
+        template<typename Setup, typename F>
+        const Result &run(const std::string &name, Setup &&setup, F &&fn) {
+            for (unsigned i = 0; i < options.warmup; i++) {
+                setup();
+                fn();
+            }
+            return measure(name, 1, setup, fn);
+        }
+
+        /**
+         * Add samples in seconds timed by the caller, such as a one-shot preprocessing step
+         */
+        const Result &record(const std::string &name, std::vector<double> samples) {
+            Result r;
+            r.name = name;
+            r.samples = std::move(samples);
+            return add(std::move(r));
+        }
+
+        const std::vector<Result> &results() const { return all; }
+
+        /**
+         * Write the context and every result with its raw samples
+         * @return false if the file could not be written
+         */
+        bool writeJson(const std::string &path) const {
+            FILE *out = std::fopen(path.c_str(), "w");
+            if (!out) return false;
+            std::fprintf(out, "{\n  \"context\": {");
+            for (size_t i = 0; i < contexts.size(); i++)
+                std::fprintf(out, "%s\n    %s: %s", i ? "," : "", quote(contexts[i].first).c_str(),
+                             quote(contexts[i].second).c_str());
+            std::fprintf(out, "\n  },\n  \"benchmarks\": [");
+            for (size_t i = 0; i < all.size(); i++) {
+                const Result &r = all[i];
+                const Summary &s = r.summary;
+                std::fprintf(out, "%s\n    {\"name\": %s, \"iterations\": %zu, \"median\": %.9g, \"mad\": %.9g, "
+                                  "\"mean\": %.9g, \"stddev\": %.9g, \"min\": %.9g, \"max\": %.9g, "
+                                  "\"ci_low\": %.9g, \"ci_high\": %.9g,\n     \"counters\": {",
+                             i ? "," : "", quote(r.name).c_str(), r.iterations, s.median, s.mad, s.mean, s.stddev,
+                             s.min, s.max, s.low, s.high);
+                for (size_t j = 0; j < r.counters.size(); j++)
+                    std::fprintf(out, "%s\"%s\": %.6g", j ? ", " : "", r.counters[j].first.c_str(),
+                                 r.counters[j].second);
+                std::fprintf(out, "},\n     \"samples\": [");
+                for (size_t j = 0; j < r.samples.size(); j++)
+                    std::fprintf(out, "%s%.9g", j ? ", " : "", r.samples[j]);
+                std::fprintf(out, "]}");
+            }
+            std::fprintf(out, "\n  ]\n}\n");
+            return std::fclose(out) == 0;
+        }
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        std::vector<std::pair<std::string, std::string>> contexts;
+        std::vector<Result> all;
+        PerfCounters perf;
+        bool header = false;
+
+        template<typename Setup, typename F>
+        const Result &measure(const std::string &name, size_t iterations, Setup &&setup, F &&fn) {
+            Result r;
+            r.name = name;
+            r.iterations = iterations;
+            std::array<std::vector<double>, PerfCounters::EVENT_COUNT> counts;
+            bool counted = true;
+            for (unsigned s = 0; s < std::max(1u, options.samples); s++) {
+                setup();
+                std::array<double, PerfCounters::EVENT_COUNT> sample;
+                perf.start();
+                auto start = Clock::now();
+                for (size_t i = 0; i < iterations; i++) fn();
+                double t = std::chrono::duration<double>(Clock::now() - start).count();
+                counted = perf.stop(sample) && counted;
+                r.samples.push_back(t / static_cast<double>(iterations));
+                for (int e = 0; e < PerfCounters::EVENT_COUNT; e++)
+                    counts[e].push_back(sample[e] / static_cast<double>(iterations));
+            }
+            if (counted) {
+                for (int e = 0; e < PerfCounters::EVENT_COUNT; e++)
+                    if (perf.has(e)) r.counters.emplace_back(PerfCounters::name(e), Summary::of(counts[e]).median);
+            }
+            return add(std::move(r));
+        }
+
+        const Result &add(Result r) {
+            r.summary = Summary::of(r.samples);
+            if (options.print && !header) {
+                std::printf("%-40s %13s    %8s  %24s  %s\n", "benchmark", "median", "MAD", "95% CI of median", "batch");
+                header = true;
+            }
+            if (options.print) print(r);
+            all.push_back(std::move(r));
+            return all.back();
+        }
+
+        static void print(const Result &r) {
+            const Summary &s = r.summary;
+            double unit = s.median >= 1 ? 1 : s.median >= 1e-3 ? 1e-3 : s.median >= 1e-6 ? 1e-6 : 1e-9;
+            const char *suffix = unit == 1 ? "s" : unit == 1e-3 ? "ms" : unit == 1e-6 ? "us" : "ns";
+            std::printf("%-40s %10.3f %-2s +- %8.3f  [%10.3f, %10.3f]  x%zu", r.name.c_str(), s.median / unit, suffix,
+                        s.mad / unit, s.low / unit, s.high / unit, r.iterations);
+            double cycles = 0, instructions = 0;
+            for (auto &c : r.counters) {
+                if (c.first == "cycles") cycles = c.second;
+                if (c.first == "instructions") instructions = c.second;
+                std::printf("  %s %.4g", c.first.c_str(), c.second);
+            }
+            if (cycles > 0 && instructions > 0) std::printf("  IPC %.2f", instructions / cycles);
+            std::printf("\n");
+            std::fflush(stdout);
+        }
+
+        static std::string quote(const std::string &s) {
+            std::string q = "\"";
+            for (char c : s) {
+                if (c == '"' || c == '\\') q += '\\';
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escape[8];
+                    std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+                    q += escape;
+                }
+                else q += c;
+            }
+            return q + "\"";
+        }
+    };
+}
+
+#endif //VE281_BENCHMARK_HPP
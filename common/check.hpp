@@ -0,0 +1,63 @@
+#ifndef VE281_CHECK_HPP
+#define VE281_CHECK_HPP
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+
+/**
+ * Minimal test harness shared by the project tests
+ *
+ * VE281_CHECK stays active in release builds, unlike assert, and keeps going after a failure so that one run
+ * reports every broken check. A test program runs its cases with Check::run and returns Check::report(),
+ * which ctest reads as the exit status.
+ */
+namespace Check {
+    inline size_t &failures() {
+        static size_t count = 0;
+        return count;
+    }
+
+    inline void fail(const char *file, int line, const char *expression) {
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+        ++failures();
+    }
+
+    /**
+     * Run one named case, an escaping exception counts as a failure
+     */
+    inline void run(const char *name, const std::function<void()> &body) {
+        size_t before = failures();
+        try {
+            body();
+        }
+        catch (const std::exception &e) {
+            std::fprintf(stderr, "%s: unexpected exception: %s\n", name, e.what());
+            ++failures();
+        }
+        std::printf("%-40s %s\n", name, failures() == before ? "ok" : "FAILED");
+    }
+
+    /**
+     * Exit status of the test program
+     */
+    inline int report() {
+        if (failures() == 0) return EXIT_SUCCESS;
+        std::fprintf(stderr, "%zu check(s) failed\n", failures());
+        return EXIT_FAILURE;
+    }
+}
+
+#define VE281_CHECK(condition) \
+    do { if (!(condition)) Check::fail(__FILE__, __LINE__, #condition); } while (0)
+
+// the statement must throw an exception of the given type
+#define VE281_CHECK_THROWS(statement, type)                                       \
+    do {                                                                          \
+        bool caught = false;                                                      \
+        try { statement; } catch (const type &) { caught = true; }                \
+        if (!caught) Check::fail(__FILE__, __LINE__, #statement " throws " #type); \
+    } while (0)
+
+#endif //VE281_CHECK_HPP
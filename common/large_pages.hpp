@@ -0,0 +1,200 @@
+#ifndef VE281_LARGE_PAGES_HPP
+#define VE281_LARGE_PAGES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+
+/**
+ * Allocation of large buffers on huge pages, optionally interleaved over NUMA nodes
+ *
+ * Random access over a buffer of several hundred megabytes misses the TLB on nearly every load with 4 KiB
+ * pages; 2 MiB pages cover 512 times as much memory per entry. Buffers of at least MAP_THRESHOLD bytes are
+ * mapped directly, aligned to a huge page, and then backed by explicit huge pages (MAP_HUGETLB, needs pages
+ * reserved in /proc/sys/vm/nr_hugepages) or transparent ones (madvise MADV_HUGEPAGE). A request the kernel
+ * refuses degrades quietly to the next weaker kind, down to ordinary pages. Smaller buffers use aligned_alloc.
+ */
+namespace LargePages {
+    enum class Pages {
+        Default,        // whatever the kernel does for anonymous memory
+        Transparent,    // ask for transparent huge pages
+        Explicit        // reserved huge pages, transparent ones if none are left
+    };
+
+    struct Policy {
+        Pages pages = Pages::Default;
+        bool interleave = false;    // spread the pages round-robin over every online NUMA node
+    };
+
+    static constexpr size_t HUGE_PAGE = size_t(2) << 20;
+    static constexpr size_t MAP_THRESHOLD = size_t(1) << 20;
+
+    /**
+     * The policy of allocations that do not name one, in particular of LargePages::Allocator
+     */
+    inline Policy &defaultPolicy() {
+        static Policy policy;
+        return policy;
+    }
+
+    namespace Detail {
+        inline size_t mappedBytes(size_t bytes) { return (bytes + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE; }
+
+        /**
+         * Online NUMA nodes as an mbind node mask, parsed from ranges such as "0-3,8"
+         */
+        inline std::vector<unsigned long> onlineNodes() {
+            std::vector<unsigned long> mask;
+            std::ifstream in("/sys/devices/system/node/online");
+            std::string list;
+            if (!(in >> list)) return mask;
+            const size_t BITS = 8 * sizeof(unsigned long);
+            size_t pos = 0;
+            while (pos < list.size()) {
+                size_t end;
+                unsigned long first = std::stoul(list.substr(pos), &end), last = first;
+                pos += end;
+                if (pos < list.size() && list[pos] == '-') {
+                    last = std::stoul(list.substr(++pos), &end);
+                    pos += end;
+                }
+                for (unsigned long node = first; node <= last; node++) {
+                    if (mask.size() <= node / BITS) mask.resize(node / BITS + 1, 0);
+                    mask[node / BITS] |= 1UL << (node % BITS);
+                }
+                if (pos < list.size() && list[pos] == ',') pos++;
+            }
+            return mask;
+        }
+
+        inline bool multipleNodes() {
+            static const bool multiple = [] {
+                size_t nodes = 0;
+                for (unsigned long word : onlineNodes()) nodes += static_cast<size_t>(__builtin_popcountl(word));
+                return nodes > 1;
+            }();
+            return multiple;
+        }
+
+#ifdef __linux__
+        /**
+         * Map length bytes starting on a huge page boundary, so that transparent huge pages can back all of it
+         */
+        inline void *mapAligned(size_t length) {
+            void *p = mmap(nullptr, length + HUGE_PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED) return nullptr;
+            uintptr_t begin = reinterpret_cast<uintptr_t>(p);
+            uintptr_t aligned = (begin + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+            if (aligned > begin) munmap(p, aligned - begin);
+            if (begin + HUGE_PAGE > aligned)
+                munmap(reinterpret_cast<void *>(aligned + length), begin + HUGE_PAGE - aligned);
+            return reinterpret_cast<void *>(aligned);
+        }
+
+        inline void *map(size_t length, const Policy &policy) {
+            void *p = nullptr;
+#ifdef MAP_HUGETLB
+            if (policy.pages == Pages::Explicit) {
+                p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+                if (p == MAP_FAILED) p = nullptr;
+            }
+#endif
+            if (p == nullptr) {
+                p = mapAligned(length);
+                if (p == nullptr) return nullptr;
+#ifdef MADV_HUGEPAGE
+                if (policy.pages != Pages::Default) madvise(p, length, MADV_HUGEPAGE);
+#endif
+            }
+#ifdef SYS_mbind
+            // before the first touch, so that every page is placed by the policy
+            if (policy.interleave && multipleNodes()) {
+                static const std::vector<unsigned long> nodes = onlineNodes();
+                syscall(SYS_mbind, p, length, MPOL_INTERLEAVE, nodes.data(), nodes.size() * 8 * sizeof(unsigned long),
+                        0);
+            }
+#endif
+            return p;
+        }
+#endif
+    }
+
+    /**
+     * Allocate an uninitialized buffer
+     * Buffers of MAP_THRESHOLD bytes or more are page-aligned whatever the alignment asked for
+     * @param alignment a power of two, at most the page size
+     * @throw std::bad_alloc
+     */
+    inline void *allocate(size_t bytes, size_t alignment = 64, const Policy &policy = defaultPolicy()) {
+        if (bytes == 0) bytes = 1;
+#ifdef __linux__
+        if (bytes >= MAP_THRESHOLD) {
+            void *p = Detail::map(Detail::mappedBytes(bytes), policy);
+            if (p == nullptr) throw std::bad_alloc();
+            return p;
+        }
+#else
+        (void) policy;
+#endif
+        if (alignment < sizeof(void *)) alignment = sizeof(void *);
+        void *p = std::aligned_alloc(alignment, (bytes + alignment - 1) / alignment * alignment);
+        if (p == nullptr) throw std::bad_alloc();
+        return p;
+    }
+
+    /**
+     * Release a buffer from allocate, bytes must be the size it was allocated with
+     */
+    inline void deallocate(void *p, size_t bytes) noexcept {
+        if (p == nullptr) return;
+        if (bytes == 0) bytes = 1;
+#ifdef __linux__
+        if (bytes >= MAP_THRESHOLD) {
+            munmap(p, Detail::mappedBytes(bytes));
+            return;
+        }
+#endif
+        std::free(p);
+    }
+
+    /**
+     * Standard allocator over allocate and deallocate with the default policy
+     * Containers keep small allocations on the heap, only their large buffers are mapped
+     */
+    template<typename T>
+    class Allocator {
+    public:
+        typedef T value_type;
+
+        Allocator() noexcept = default;
+
+        template<typename U>
+        Allocator(const Allocator<U> &) noexcept {}
+
+        T *allocate(size_t n) {
+            if (n > static_cast<size_t>(-1) / sizeof(T)) throw std::bad_alloc();
+            return static_cast<T *>(LargePages::allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T *p, size_t n) noexcept { LargePages::deallocate(p, n * sizeof(T)); }
+
+        template<typename U>
+        bool operator==(const Allocator<U> &) const noexcept { return true; }
+
+        template<typename U>
+        bool operator!=(const Allocator<U> &) const noexcept { return false; }
+    };
+}
+
+#endif //VE281_LARGE_PAGES_HPP
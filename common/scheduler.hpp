@@ -0,0 +1,361 @@
+#ifndef VE281_SCHEDULER_HPP
+#define VE281_SCHEDULER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * Work-stealing fork/join scheduler shared by the projects
+ *
+ * Every worker owns a Chase-Lev deque: it pushes and pops forked tasks at the bottom, idle workers steal from
+ * the top. A join runs other tasks while it waits, so nested parallelism never blocks a worker. Tasks live on
+ * the stack of the forking thread, a fork allocates nothing once the deques have grown.
+ */
+namespace Parallel {
+    /**
+     * Chase-Lev work-stealing deque (Le, Pop, Cohen, Zappa Nardelli, PPoPP 2013 formulation)
+     * push / pop by the owner thread only, steal by any thread; the ring grows by doubling, and old rings are
+     * kept until destruction since a concurrent thief may still read them
+     */
+    template<typename T>
+    class WorkStealingDeque {
+    public:
+        explicit WorkStealingDeque(size_t capacity = 256) {
+            rings.push_back(std::make_unique<Ring>(capacity));
+            ring.store(rings.back().get(), std::memory_order_relaxed);
+        }
+
+        WorkStealingDeque(const WorkStealingDeque &) = delete;
+
+        WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+        void push(T x) {
+            int64_t b = bottom.load(std::memory_order_relaxed), t = top.load(std::memory_order_acquire);
+            Ring *r = ring.load(std::memory_order_relaxed);
+            if (b - t > static_cast<int64_t>(r->mask)) r = grow(r, t, b);
+            r->put(b, x);
+            bottom.store(b + 1, std::memory_order_release);
+        }
+
+        /**
+         * @return false if the deque is empty or a thief took the last element
+         */
+        bool pop(T &x) {
+            int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+            Ring *r = ring.load(std::memory_order_relaxed);
+            bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = top.load(std::memory_order_relaxed);
+            if (t > b) {
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+            x = r->get(b);
+            if (t < b) return true;
+            // last element, race the thieves for it
+            bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+
+        /**
+         * @return false if the deque is empty or another thread won the top element
+         */
+        bool steal(T &x) {
+            int64_t t = top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t b = bottom.load(std::memory_order_acquire);
+            if (t >= b) return false;
+            x = ring.load(std::memory_order_acquire)->get(t);
+            return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        }
+
+    private:
+        struct Ring {
+            size_t mask;
+            std::unique_ptr<std::atomic<T>[]> slots;
+
+            explicit Ring(size_t capacity) : mask(capacity - 1), slots(new std::atomic<T>[capacity]) {}
+
+            T get(int64_t i) const { return slots[static_cast<size_t>(i) & mask].load(std::memory_order_relaxed); }
+
+            void put(int64_t i, T x) { slots[static_cast<size_t>(i) & mask].store(x, std::memory_order_relaxed); }
+        };
+
+        alignas(64) std::atomic<int64_t> top{0};
+        alignas(64) std::atomic<int64_t> bottom{0};
+        std::atomic<Ring *> ring{nullptr};
+        std::vector<std::unique_ptr<Ring>> rings;   // owner only
+
+        Ring *grow(Ring *r, int64_t t, int64_t b) {
+            rings.push_back(std::make_unique<Ring>(2 * (r->mask + 1)));
+            Ring *bigger = rings.back().get();
+            for (int64_t i = t; i < b; i++) bigger->put(i, r->get(i));
+            ring.store(bigger, std::memory_order_release);
+            return bigger;
+        }
+    };
+
+    class Scheduler;
+
+    namespace Detail {
+        struct Task {
+            std::atomic<bool> done{false};
+            std::exception_ptr error;
+
+            virtual void run() = 0;
+
+            void execute() {
+                try {
+                    run();
+                }
+                catch (...) {
+                    error = std::current_exception();
+                }
+                // the forking thread may return as soon as it sees done, so the task is not touched afterwards
+                done.store(true, std::memory_order_release);
+            }
+
+        protected:
+            ~Task() = default;
+        };
+
+        template<typename F>
+        struct FunctionTask final : Task {
+            F &f;
+
+            explicit FunctionTask(F &f) : f(f) {}
+
+            void run() override { f(); }
+        };
+
+        inline thread_local Scheduler *currentScheduler = nullptr;
+        inline thread_local int currentWorker = -1;
+    }
+
+    /**
+     * A fixed set of worker threads; fork / join through invoke, or the loops below
+     * Outside threads hand their work to the workers through run and sleep until it is done
+     */
+    class Scheduler {
+    public:
+        explicit Scheduler(unsigned threads = std::thread::hardware_concurrency()) {
+            threads = std::max(1u, threads);
+            for (unsigned i = 0; i < threads; i++) workers.push_back(std::make_unique<Worker>());
+            for (unsigned i = 0; i < threads; i++) workers[i]->thread = std::thread([this, i]() { loop(i); });
+        }
+
+        Scheduler(const Scheduler &) = delete;
+
+        Scheduler &operator=(const Scheduler &) = delete;
+
+        ~Scheduler() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stop = true;
+            }
+            wake.notify_all();
+            for (auto &w : workers) w->thread.join();
+        }
+
+        unsigned concurrency() const { return static_cast<unsigned>(workers.size()); }
+
+        /**
+         * @return the index in [0, concurrency()) of the calling worker, -1 outside any scheduler
+         * Per-worker scratch indexed by it needs no locking
+         */
+        static int workerIndex() { return Detail::currentWorker; }
+
+        /**
+         * Run f on a worker and wait for it, f may fork; runs f directly when called from a worker
+         * @throw whatever f throws
+         */
+        template<typename F>
+        void run(F &&f) {
+            if (Detail::currentScheduler == this) {
+                f();
+                return;
+            }
+            std::mutex doneMutex;
+            std::condition_variable doneSignal;
+            bool finished = false;
+            auto root = [&]() {
+                struct Notify {
+                    std::mutex &m;
+                    std::condition_variable &c;
+                    bool &flag;
+
+                    ~Notify() {
+                        std::lock_guard<std::mutex> lock(m);
+                        flag = true;
+                        c.notify_one();
+                    }
+                } notify{doneMutex, doneSignal, finished};
+                f();
+            };
+            Detail::FunctionTask<decltype(root)> task(root);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                injected.push_back(&task);
+                injectedCount.fetch_add(1, std::memory_order_relaxed);
+            }
+            signal();
+            std::unique_lock<std::mutex> lock(doneMutex);
+            doneSignal.wait(lock, [&finished]() { return finished; });
+            lock.unlock();
+            // done is set after the notification, the task must not be destroyed under the worker
+            while (!task.done.load(std::memory_order_acquire)) std::this_thread::yield();
+            if (task.error) std::rethrow_exception(task.error);
+        }
+
+        /**
+         * Run f and g, possibly in parallel, and return when both are done
+         * g is offered to thieves while the caller runs f
+         * @throw the exception of f, else of g
+         */
+        template<typename F, typename G>
+        void invoke(F &&f, G &&g) {
+            if (Detail::currentScheduler != this) {
+                run([&]() { invoke(f, g); });
+                return;
+            }
+            Worker &self = *workers[Detail::currentWorker];
+            Detail::FunctionTask<G> forked(g);
+            self.deque.push(&forked);
+            signal();
+            std::exception_ptr error;
+            try {
+                f();
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+            // join: g is at the bottom unless stolen, in the meantime help with anything else
+            while (!forked.done.load(std::memory_order_acquire)) {
+                Detail::Task *task;
+                if (self.deque.pop(task) || findTask(Detail::currentWorker, task)) task->execute();
+                else std::this_thread::yield();
+            }
+            if (error) std::rethrow_exception(error);
+            if (forked.error) std::rethrow_exception(forked.error);
+        }
+
+    private:
+        struct Worker {
+            WorkStealingDeque<Detail::Task *> deque;
+            std::thread thread;
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::mutex mutex;                       // guards injected, stop and sleeping
+        std::condition_variable wake;
+        std::deque<Detail::Task *> injected;    // tasks handed in by outside threads
+        std::atomic<size_t> injectedCount{0};   // its size, read without the lock
+        std::atomic<uint64_t> epoch{0};         // bumped on every new task, so a worker going idle can not miss it
+        std::atomic<unsigned> sleeping{0};
+        bool stop = false;
+
+        void signal() {
+            epoch.fetch_add(1, std::memory_order_seq_cst);
+            if (sleeping.load(std::memory_order_seq_cst) > 0) {
+                std::lock_guard<std::mutex> lock(mutex);
+                wake.notify_one();
+            }
+        }
+
+        // steal from the other workers in turn starting after self, then take an injected task
+        bool findTask(unsigned self, Detail::Task *&task) {
+            unsigned n = concurrency();
+            for (unsigned k = 1; k < n; k++)
+                if (workers[(self + k) % n]->deque.steal(task)) return true;
+            if (injectedCount.load(std::memory_order_relaxed) == 0) return false;
+            std::lock_guard<std::mutex> lock(mutex);
+            if (injected.empty()) return false;
+            task = injected.front();
+            injected.pop_front();
+            injectedCount.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        void loop(unsigned index) {
+            Detail::currentScheduler = this;
+            Detail::currentWorker = static_cast<int>(index);
+            Worker &self = *workers[index];
+            while (true) {
+                uint64_t seen = epoch.load(std::memory_order_seq_cst);
+                Detail::Task *task;
+                if (self.deque.pop(task) || findTask(index, task)) {
+                    task->execute();
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(mutex);
+                if (stop) return;
+                sleeping.fetch_add(1, std::memory_order_seq_cst);
+                wake.wait(lock, [&]() { return stop || epoch.load(std::memory_order_seq_cst) != seen; });
+                sleeping.fetch_sub(1, std::memory_order_seq_cst);
+            }
+        }
+    };
+
+    /**
+     * Process-wide scheduler with one worker per hardware thread, started on first use
+     */
+    inline Scheduler &defaultScheduler() {
+        static Scheduler scheduler;
+        return scheduler;
+    }
+
+    /**
+     * Run f and g in parallel, return when both are done
+     */
+    template<typename F, typename G>
+    void invoke(F &&f, G &&g, Scheduler &scheduler = defaultScheduler()) {
+        scheduler.invoke(std::forward<F>(f), std::forward<G>(g));
+    }
+
+    /**
+     * body(begin, end) over subranges of [first, last) of at most grain indices, split recursively in halves
+     * Time Complexity: O((last - first) / grain) tasks, span O(log((last - first) / grain)) forks
+     */
+    template<typename Index, typename Body>
+    void forRange(Index first, Index last, Index grain, Body &&body, Scheduler &scheduler = defaultScheduler()) {
+        if (first >= last) return;
+        grain = std::max<Index>(grain, 1);
+        if (last - first <= grain) {
+            body(first, last);
+            return;
+        }
+        Index mid = first + (last - first) / 2;
+        scheduler.invoke([&]() { forRange(first, mid, grain, body, scheduler); },
+                         [&]() { forRange(mid, last, grain, body, scheduler); });
+    }
+
+    /**
+     * combine over map(begin, end) of subranges of [first, last) of at most grain indices
+     * combine must be associative; subranges are combined in index order, so it need not be commutative
+     * @return identity for an empty range
+     */
+    template<typename Index, typename T, typename Map, typename Combine>
+    T reduce(Index first, Index last, Index grain, T identity, Map &&map, Combine &&combine,
+             Scheduler &scheduler = defaultScheduler()) {
+        if (first >= last) return identity;
+        grain = std::max<Index>(grain, 1);
+        if (last - first <= grain) return map(first, last);
+        Index mid = first + (last - first) / 2;
+        T left = identity, right = identity;
+        scheduler.invoke([&]() { left = reduce(first, mid, grain, identity, map, combine, scheduler); },
+                         [&]() { right = reduce(mid, last, grain, identity, map, combine, scheduler); });
+        return combine(std::move(left), std::move(right));
+    }
+}
+
+#endif //VE281_SCHEDULER_HPP